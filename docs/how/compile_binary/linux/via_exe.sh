@@ -0,0 +1,2 @@
+#/bin/sh
+../TypeScriptCompiler/__build/tsc-ninja/bin/tsc --emit=exe -nogc -o 1.out /mnt/c/temp/1.ts
@@ -0,0 +1,82 @@
+#!/bin/bash
+
+# Measures time of the lowering to LLVM dialect for generated programs of growing size (N functions, each one prints
+# its own string constant and declares/calls runtime functions). Time per function should stay the same when N grows.
+
+scriptdir=`dirname ${0}`
+scriptdir=`(cd ${scriptdir}; pwd)`
+scriptname=`basename ${0}`
+
+set -e
+
+function errorexit()
+{
+  errorcode=${1}
+  shift
+  echo $@
+  exit ${errorcode}
+}
+
+function usage()
+{
+  echo "USAGE ${scriptname} <path to tsc> [sizes]"
+}
+
+tsc="$1"
+shift || true
+sizes="${@:-500 1000 2000 4000 8000}"
+
+if [ -z "${tsc}" ] ; then
+  usage
+  errorexit 0 "path to tsc must be specified"
+fi
+
+workdir=`mktemp -d`
+trap "rm -rf ${workdir}" EXIT
+
+function generate()
+{
+  count=${1}
+  file=${2}
+
+  : > ${file}
+  for ((i = 0; i < count; i++)) ; do
+    echo "function f${i}(n: number) { print(\"string constant ${i}\", n); return \`${i}: \${n}\`; }" >> ${file}
+  done
+
+  echo "function main() {" >> ${file}
+  for ((i = 0; i < count; i++)) ; do
+    echo "  f${i}(${i});" >> ${file}
+  done
+  echo "}" >> ${file}
+}
+
+function loweringTime()
+{
+  python3 - "$1" <<'EOF'
+import json, sys
+
+def find(node):
+    if "TypeScriptToLLVMLoweringPass" in node["name"]:
+        return node["wall"]
+    for child in node.get("children", []):
+        found = find(child)
+        if found is not None:
+            return found
+    return None
+
+print(find(json.load(open(sys.argv[1]))))
+EOF
+}
+
+# "growth" is time per function relative to the smallest program, it stays near 1 when the lowering is linear
+printf "%10s %12s %16s %8s\n" "functions" "lowering, s" "per function, us" "growth"
+first=
+for size in ${sizes} ; do
+  generate ${size} ${workdir}/bench_${size}.ts
+  "${tsc}" --emit=mlir-llvm -nogc --time-report=json --time-report-file=${workdir}/report_${size}.json ${workdir}/bench_${size}.ts > /dev/null
+  seconds=`loweringTime ${workdir}/report_${size}.json`
+  perFunction=`python3 -c "print(${seconds} * 1000000 / ${size})"`
+  first=${first:-${perFunction}}
+  printf "%10d %12.3f %16.1f %8.2f\n" ${size} ${seconds} ${perFunction} `python3 -c "print(${perFunction} / ${first})"`
+done
@@ -0,0 +1,88 @@
+#!/bin/bash
+
+# Compares time of the lowering to LLVM dialect ("TypeScriptToLLVMLoweringPass" in --time-report) of generated programs
+# of growing size (N functions, each one prints its own string constant and calls runtime functions) without and with
+# --parallel-lowering.
+
+scriptdir=`dirname ${0}`
+scriptdir=`(cd ${scriptdir}; pwd)`
+scriptname=`basename ${0}`
+
+set -e
+
+function errorexit()
+{
+  errorcode=${1}
+  shift
+  echo $@
+  exit ${errorcode}
+}
+
+function usage()
+{
+  echo "USAGE ${scriptname} <path to tsc> [sizes]"
+}
+
+tsc="$1"
+shift || true
+sizes="${@:-1000 2000 4000 8000}"
+
+if [ -z "${tsc}" ] ; then
+  usage
+  errorexit 0 "path to tsc must be specified"
+fi
+
+workdir=`mktemp -d`
+trap "rm -rf ${workdir}" EXIT
+
+function generate()
+{
+  count=${1}
+  file=${2}
+
+  : > ${file}
+  for ((i = 0; i < count; i++)) ; do
+    echo "function f${i}(n: number) { print(\"string constant ${i}\", n); return \`${i}: \${n}\`; }" >> ${file}
+  done
+
+  echo "function main() {" >> ${file}
+  for ((i = 0; i < count; i++)) ; do
+    echo "  f${i}(${i});" >> ${file}
+  done
+  echo "}" >> ${file}
+}
+
+function loweringTime()
+{
+  python3 - "$1" <<'EOF'
+import json, sys
+
+def find(node):
+    if "TypeScriptToLLVMLoweringPass" in node["name"]:
+        return node["wall"]
+    for child in node.get("children", []):
+        found = find(child)
+        if found is not None:
+            return found
+    return None
+
+print(find(json.load(open(sys.argv[1]))))
+EOF
+}
+
+function compile()
+{
+  file=${1}
+  report=${2}
+  shift 2
+  "${tsc}" --emit=mlir-llvm -nogc --time-report=json --time-report-file=${report} "$@" ${file} > /dev/null
+  loweringTime ${report}
+}
+
+printf "%10s %12s %12s %10s\n" "functions" "lowering, s" "parallel, s" "speedup"
+for size in ${sizes} ; do
+  generate ${size} ${workdir}/bench_${size}.ts
+  serial=`compile ${workdir}/bench_${size}.ts ${workdir}/report_${size}.json`
+  parallel=`compile ${workdir}/bench_${size}.ts ${workdir}/report_parallel_${size}.json --parallel-lowering`
+  printf "%10d %12.3f %12.3f %10.2f\n" ${size} ${serial} ${parallel} `python3 -c "print(${serial} / ${parallel})"`
+done
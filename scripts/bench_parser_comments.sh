@@ -0,0 +1,73 @@
+#!/bin/bash
+
+# Measures time of the parsing of comment-dense sources (large JSDoc headers, single line comments and triple-slash
+# directives in front of every function), the AST dump of generated programs of growing size is timed.
+
+scriptdir=`dirname ${0}`
+scriptdir=`(cd ${scriptdir}; pwd)`
+scriptname=`basename ${0}`
+
+set -e
+
+function errorexit()
+{
+  errorcode=${1}
+  shift
+  echo $@
+  exit ${errorcode}
+}
+
+function usage()
+{
+  echo "USAGE ${scriptname} <path to tsc> [sizes]"
+}
+
+tsc="$1"
+shift || true
+sizes="${@:-1000 2000 4000 8000}"
+
+if [ -z "${tsc}" ] ; then
+  usage
+  errorexit 0 "path to tsc must be specified"
+fi
+
+workdir=`mktemp -d`
+trap "rm -rf ${workdir}" EXIT
+
+function generate()
+{
+  count=${1}
+  file=${2}
+
+  : > ${file}
+  for ((i = 0; i < count; i++)) ; do
+    echo "/// <reference path=\"dependency${i}.d.ts\" />" >> ${file}
+    echo "/**" >> ${file}
+    for ((j = 0; j < 10; j++)) ; do
+      echo " * Generated function ${i}, line ${j} of the description of what the function does and why." >> ${file}
+    done
+    echo " * @param n value to print" >> ${file}
+    echo " * @returns text of the value" >> ${file}
+    echo " */" >> ${file}
+    echo "// @ts-ignore" >> ${file}
+    echo "function f${i}(n: number) { /* value */ return \`${i}: \${n}\`; } // trailing comment" >> ${file}
+  done
+}
+
+function elapsed()
+{
+  python3 - "$@" <<'EOF'
+import subprocess, sys, time
+
+start = time.perf_counter()
+subprocess.run(sys.argv[1:], stdout=subprocess.DEVNULL, check=True)
+print(time.perf_counter() - start)
+EOF
+}
+
+printf "%10s %12s %16s\n" "functions" "parsing, s" "per function, us"
+for size in ${sizes} ; do
+  generate ${size} ${workdir}/bench_${size}.ts
+  seconds=`elapsed "${tsc}" --emit=ast ${workdir}/bench_${size}.ts`
+  printf "%10d %12.3f %16.1f\n" ${size} ${seconds} `python3 -c "print(${seconds} * 1000000 / ${size})"`
+done
@@ -0,0 +1,70 @@
+#!/bin/bash
+
+# Measures throughput of the parser in MB/s, the sources of test/tester/tests are concatenated (repeated N times to
+# get inputs of growing size) and the AST dump of them is timed. Throughput should stay the same when N grows.
+
+scriptdir=`dirname ${0}`
+scriptdir=`(cd ${scriptdir}; pwd)`
+scriptname=`basename ${0}`
+
+set -e
+
+function errorexit()
+{
+  errorcode=${1}
+  shift
+  echo $@
+  exit ${errorcode}
+}
+
+function usage()
+{
+  echo "USAGE ${scriptname} <path to tsc> [scales]"
+}
+
+tsc="$1"
+shift || true
+scales="${@:-1 4 16 32}"
+
+if [ -z "${tsc}" ] ; then
+  usage
+  errorexit 0 "path to tsc must be specified"
+fi
+
+testsdir=${scriptdir}/../tsc/test/tester/tests
+
+workdir=`mktemp -d`
+trap "rm -rf ${workdir}" EXIT
+
+function generate()
+{
+  count=${1}
+  file=${2}
+
+  : > ${file}
+  for ((i = 0; i < count; i++)) ; do
+    for test in ${testsdir}/*.ts ; do
+      cat ${test} >> ${file}
+      echo >> ${file}
+    done
+  done
+}
+
+function elapsed()
+{
+  python3 - "$@" <<'EOF'
+import subprocess, sys, time
+
+start = time.perf_counter()
+subprocess.run(sys.argv[1:], stdout=subprocess.DEVNULL, check=True)
+print(time.perf_counter() - start)
+EOF
+}
+
+printf "%10s %10s %12s %10s\n" "scale" "size, MB" "parsing, s" "MB/s"
+for scale in ${scales} ; do
+  generate ${scale} ${workdir}/bench_${scale}.ts
+  megabytes=`python3 -c "import os; print(os.path.getsize('${workdir}/bench_${scale}.ts') / 1000000)"`
+  seconds=`elapsed "${tsc}" --emit=ast ${workdir}/bench_${scale}.ts`
+  printf "%10d %10.2f %12.3f %10.2f\n" ${scale} ${megabytes} ${seconds} `python3 -c "print(${megabytes} / ${seconds})"`
+done
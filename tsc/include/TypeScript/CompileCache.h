@@ -0,0 +1,92 @@
+#ifndef TYPESCRIPT_COMPILECACHE_H_
+#define TYPESCRIPT_COMPILECACHE_H_
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ExecutionEngine/ObjectCache.h"
+
+#include <string>
+#include <vector>
+
+namespace typescript
+{
+
+/// On-disk cache of compilation results (LLVM bitcode, object files).
+///
+/// Entry is found in two steps: the key of the input file (content, compiler build, options) points to the list of
+/// dependencies (include and import files) recorded at the time of the first compilation, then the key of the artifact
+/// is calculated from the input key and the current content of all dependencies, so changed dependency gives new
+/// artifact.
+class CompileCache
+{
+  public:
+    CompileCache(llvm::StringRef cacheDir) : cacheDir(cacheDir.str())
+    {
+    }
+
+    /// returns true if artifact for the input is in the cache, see getArtifactPath()
+    bool lookup(llvm::StringRef fileName, llvm::StringRef source, llvm::StringRef optionsKey, llvm::StringRef ext);
+
+    /// copies produced file into the cache and records dependencies of the input, imported modules are compiled
+    /// separately, they are recorded to be linked with the artifact
+    bool store(llvm::ArrayRef<std::string> dependencies, llvm::StringRef producedFilePath,
+               llvm::ArrayRef<std::string> importedModules = {});
+
+    /// path to temporary file in the cache folder to produce artifact in
+    std::string getTempFilePath();
+
+    llvm::StringRef getArtifactPath()
+    {
+        return artifactPath;
+    }
+
+    /// imported modules recorded with the artifact found by lookup()
+    llvm::ArrayRef<std::string> getImportedModules()
+    {
+        return importedModules;
+    }
+
+    /// removes least recently used files until the size of the cache folder is not bigger than maxSize
+    static void prune(llvm::StringRef cacheDir, uint64_t maxSize);
+
+  private:
+    bool calculateArtifactKey(llvm::ArrayRef<std::string> dependencies, std::string &artifactKey);
+
+    std::string cacheDir;
+    std::string inputKey;
+    std::string ext;
+    std::string artifactPath;
+    std::vector<std::string> importedModules;
+};
+
+/// Persistent llvm::ObjectCache for JIT, shares the folder with CompileCache.
+///
+/// The object is stored under the key of the module before optimization (see getModuleKey), the key is set as the
+/// module identifier, so the JIT can skip optimization of the module which object is in the cache already.
+class JitObjectCache : public llvm::ObjectCache
+{
+  public:
+    JitObjectCache(llvm::StringRef cacheDir, llvm::StringRef optionsKey)
+        : cacheDir(cacheDir.str()), optionsKey(optionsKey.str())
+    {
+    }
+
+    /// key of the module content, compiler build and options
+    std::string getModuleKey(const llvm::Module &module);
+
+    bool contains(llvm::StringRef moduleKey);
+
+    void notifyObjectCompiled(const llvm::Module *module, llvm::MemoryBufferRef obj) override;
+
+    std::unique_ptr<llvm::MemoryBuffer> getObject(const llvm::Module *module) override;
+
+  private:
+    std::string getObjectPath(llvm::StringRef moduleKey);
+
+    std::string cacheDir;
+    std::string optionsKey;
+};
+
+} // namespace typescript
+
+#endif // TYPESCRIPT_COMPILECACHE_H_
@@ -0,0 +1,49 @@
+#ifndef TYPESCRIPT_COMPILESERVER_H_
+#define TYPESCRIPT_COMPILESERVER_H_
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringRef.h"
+
+#include <cstdint>
+#include <string>
+
+namespace typescript
+{
+
+struct CompileServerOptions
+{
+    /// number of worker processes, each one runs one request at a time
+    unsigned workers = 1;
+    /// a worker is replaced by a new one after this number of requests, 0 - never
+    unsigned maxRequests = 0;
+    /// a worker is replaced by a new one when its heap is larger than this number of bytes after a request, 0 - never
+    uint64_t maxMemory = 0;
+};
+
+/// Listens on Unix-domain socket and runs requests in worker processes, several requests at the same time.
+///
+/// Request is the command line of the client, its working folder and its stdin/stdout/stderr handles, so input ('-') is
+/// read from the client and all output of the compiler (and of the JIT-ed code) goes directly to the client. The result
+/// of the handler is sent back as exit code.
+/// Requests are accepted from the processes of the same user only. If 'socketPath' is empty, the default socket is
+/// created in the folder accessible to the user only ($XDG_RUNTIME_DIR or tsc-<uid> in temp folder).
+///
+/// Options of the compiler, the working folder and the output handles belong to the process, so each worker runs one
+/// request at a time. 'initWorker' creates the warm state of a worker (its context), the state is released with the
+/// worker when it is replaced (see CompileServerOptions).
+///
+/// The server runs until it is stopped by SIGTERM or SIGINT, it stops its workers and removes the socket then.
+int runCompileServer(llvm::StringRef socketPath, const CompileServerOptions &options, llvm::function_ref<void()> initWorker,
+                     llvm::function_ref<int(llvm::ArrayRef<std::string>)> handler);
+
+/// Runs the action in a child process (a fork of this one), its result is the exit code of the child. The child can
+/// exit or crash without taking down the server.
+int runInChildProcess(llvm::function_ref<int()> action);
+
+/// Sends the command line to the compile server (of the same user) and returns its exit code.
+int runCompileServerClient(llvm::StringRef socketPath, llvm::ArrayRef<std::string> args);
+
+} // namespace typescript
+
+#endif // TYPESCRIPT_COMPILESERVER_H_
@@ -1,9 +1,18 @@
 #ifndef DATASTRUCT_H_
 #define DATASTRUCT_H_
 
+#include <memory>
+
+namespace typescript
+{
+class IncludeFilesCache;
+} // namespace typescript
+
 struct CompileOptions
 {
     bool disableGC;
+    // parsed include files kept between compilations, optional
+    std::shared_ptr<typescript::IncludeFilesCache> includeFilesCache;
 };
 
 #endif // DATASTRUCT_H_
\ No newline at end of file
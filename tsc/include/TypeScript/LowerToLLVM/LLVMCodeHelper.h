@@ -99,14 +99,15 @@ class LLVMCodeHelper : public LLVMCodeHelperBase
 
         // Create the global at the entry of the module.
         LLVM::GlobalOp global;
-        if (!(global = parentModule.lookupSymbol<LLVM::GlobalOp>(name)))
+        if (!(global = lookupModuleSymbol<LLVM::GlobalOp>(parentModule, name)))
         {
             OpBuilder::InsertionGuard insertGuard(rewriter);
-            rewriter.setInsertionPointToStart(parentModule.getBody());
+            auto symbolsBlock = getSymbolsBlock(parentModule);
+            rewriter.setInsertionPointToStart(symbolsBlock);
 
-            seekLast(parentModule.getBody());
+            seekLast(symbolsBlock);
 
-            global = rewriter.create<LLVM::GlobalOp>(loc, type, isConst, linkage, name, value);
+            global = createModuleSymbol<LLVM::GlobalOp>(parentModule, loc, type, isConst, linkage, name, value);
 
             {
                 setStructWritingPoint(global);
@@ -131,14 +132,15 @@ class LLVMCodeHelper : public LLVMCodeHelperBase
 
         // Create the global at the entry of the module.
         LLVM::GlobalOp global;
-        if (!(global = parentModule.lookupSymbol<LLVM::GlobalOp>(name)))
+        if (!(global = lookupModuleSymbol<LLVM::GlobalOp>(parentModule, name)))
         {
             OpBuilder::InsertionGuard insertGuard(rewriter);
-            rewriter.setInsertionPointToStart(parentModule.getBody());
+            auto symbolsBlock = getSymbolsBlock(parentModule);
+            rewriter.setInsertionPointToStart(symbolsBlock);
 
-            seekLast(parentModule.getBody());
+            seekLast(symbolsBlock);
 
-            global = rewriter.create<LLVM::GlobalOp>(loc, type, isConst, linkage, name, value);
+            global = createModuleSymbol<LLVM::GlobalOp>(parentModule, loc, type, isConst, linkage, name, value);
 
             if (!value && !initRegion.empty())
             {
@@ -211,15 +213,16 @@ class LLVMCodeHelper : public LLVMCodeHelperBase
         TypeHelper th(rewriter);
 
         // Create the global at the entry of the module.
-        LLVM::GlobalOp global = parentModule.lookupSymbol<LLVM::GlobalOp>(name);
+        LLVM::GlobalOp global = lookupModuleSymbol<LLVM::GlobalOp>(parentModule, name);
         if (!global)
         {
             OpBuilder::InsertionGuard insertGuard(rewriter);
-            rewriter.setInsertionPointToStart(parentModule.getBody());
+            auto symbolsBlock = getSymbolsBlock(parentModule);
+            rewriter.setInsertionPointToStart(symbolsBlock);
 
-            seekLast(parentModule.getBody());
+            seekLast(symbolsBlock);
 
-            global = rewriter.create<LLVM::GlobalOp>(loc, type, true, linkage, name, mlir::Attribute());
+            global = createModuleSymbol<LLVM::GlobalOp>(parentModule, loc, type, true, linkage, name, mlir::Attribute());
 
             {
                 setStructWritingPoint(global);
@@ -297,29 +300,32 @@ class LLVMCodeHelper : public LLVMCodeHelperBase
 
         // Create the global at the entry of the module.
         LLVM::GlobalOp global;
-        if (!(global = parentModule.lookupSymbol<LLVM::GlobalOp>(name)))
+        if (!(global = lookupModuleSymbol<LLVM::GlobalOp>(parentModule, name)))
         {
             OpBuilder::InsertionGuard insertGuard(rewriter);
-            rewriter.setInsertionPointToStart(parentModule.getBody());
+            auto symbolsBlock = getSymbolsBlock(parentModule);
+            rewriter.setInsertionPointToStart(symbolsBlock);
 
             // dense value
             auto value = arrayAttr.getValue();
             if (llvmElementType.isIntOrFloat())
             {
-                seekLast<DenseElementsAttr>(parentModule.getBody());
+                seekLast<DenseElementsAttr>(symbolsBlock);
 
                 // end
                 auto dataType = mlir::VectorType::get({static_cast<int64_t>(value.size())}, llvmElementType);
                 auto attr = DenseElementsAttr::get(dataType, value);
-                global = rewriter.create<LLVM::GlobalOp>(loc, /*arrayType*/dataType, true, LLVM::Linkage::Internal, name, attr);
+                global = createModuleSymbol<LLVM::GlobalOp>(parentModule, loc, /*arrayType*/dataType, true,
+                                                            LLVM::Linkage::Internal, name, attr);
             }
             else if (originalElementType.dyn_cast_or_null<mlir_ts::StringType>())
             {
-                seekLast(parentModule.getBody());
+                seekLast(symbolsBlock);
 
                 OpBuilder::InsertionGuard guard(rewriter);
 
-                global = rewriter.create<LLVM::GlobalOp>(loc, arrayType, true, LLVM::Linkage::Internal, name, mlir::Attribute{});
+                global = createModuleSymbol<LLVM::GlobalOp>(parentModule, loc, arrayType, true,
+                                                            LLVM::Linkage::Internal, name, mlir::Attribute{});
 
                 setStructWritingPoint(global);
 
@@ -338,11 +344,12 @@ class LLVMCodeHelper : public LLVMCodeHelperBase
             }
             else if (originalElementType.dyn_cast_or_null<mlir_ts::AnyType>())
             {
-                seekLast(parentModule.getBody());
+                seekLast(symbolsBlock);
 
                 OpBuilder::InsertionGuard guard(rewriter);
 
-                global = rewriter.create<LLVM::GlobalOp>(loc, arrayType, true, LLVM::Linkage::Internal, name, mlir::Attribute{});
+                global = createModuleSymbol<LLVM::GlobalOp>(parentModule, loc, arrayType, true,
+                                                            LLVM::Linkage::Internal, name, mlir::Attribute{});
 
                 setStructWritingPoint(global);
 
@@ -358,11 +365,12 @@ class LLVMCodeHelper : public LLVMCodeHelperBase
             }
             else if (auto originalArrayType = originalElementType.dyn_cast_or_null<mlir_ts::ArrayType>())
             {
-                seekLast(parentModule.getBody());
+                seekLast(symbolsBlock);
 
                 OpBuilder::InsertionGuard guard(rewriter);
 
-                global = rewriter.create<LLVM::GlobalOp>(loc, arrayType, true, LLVM::Linkage::Internal, name, mlir::Attribute{});
+                global = createModuleSymbol<LLVM::GlobalOp>(parentModule, loc, arrayType, true,
+                                                            LLVM::Linkage::Internal, name, mlir::Attribute{});
 
                 setStructWritingPoint(global);
 
@@ -388,11 +396,12 @@ class LLVMCodeHelper : public LLVMCodeHelperBase
             }
             else if (auto tupleType = originalElementType.dyn_cast_or_null<mlir_ts::TupleType>())
             {
-                seekLast(parentModule.getBody());
+                seekLast(symbolsBlock);
 
                 OpBuilder::InsertionGuard guard(rewriter);
 
-                global = rewriter.create<LLVM::GlobalOp>(loc, arrayType, true, LLVM::Linkage::Internal, name, mlir::Attribute{});
+                global = createModuleSymbol<LLVM::GlobalOp>(parentModule, loc, arrayType, true,
+                                                            LLVM::Linkage::Internal, name, mlir::Attribute{});
 
                 setStructWritingPoint(global);
 
@@ -433,7 +442,6 @@ class LLVMCodeHelper : public LLVMCodeHelperBase
     {
         Region &region = globalOp.getInitializerRegion();
         mlir::Block *block = rewriter.createBlock(&region);
-
         rewriter.setInsertionPoint(block, block->begin());
 
         return mlir::success();
@@ -590,14 +598,16 @@ class LLVMCodeHelper : public LLVMCodeHelperBase
 
         // Create the global at the entry of the module.
         LLVM::GlobalOp global;
-        if (!(global = parentModule.lookupSymbol<LLVM::GlobalOp>(name)))
+        if (!(global = lookupModuleSymbol<LLVM::GlobalOp>(parentModule, name)))
         {
             OpBuilder::InsertionGuard insertGuard(rewriter);
-            rewriter.setInsertionPointToStart(parentModule.getBody());
+            auto symbolsBlock = getSymbolsBlock(parentModule);
+            rewriter.setInsertionPointToStart(symbolsBlock);
 
-            seekLast(parentModule.getBody());
+            seekLast(symbolsBlock);
 
-            global = rewriter.create<LLVM::GlobalOp>(loc, llvmStructType, true, LLVM::Linkage::Internal, name, mlir::Attribute{});
+            global = createModuleSymbol<LLVM::GlobalOp>(parentModule, loc, llvmStructType, true,
+                                                        LLVM::Linkage::Internal, name, mlir::Attribute{});
 
             setStructWritingPoint(global);
 
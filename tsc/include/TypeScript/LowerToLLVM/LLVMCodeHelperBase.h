@@ -1,6 +1,7 @@
 #ifndef MLIR_TYPESCRIPT_LOWERTOLLVMLOGIC_LLVMCODEHELPERWRAP_H_
 #define MLIR_TYPESCRIPT_LOWERTOLLVMLOGIC_LLVMCODEHELPERWRAP_H_
 
+#include "TypeScript/LowerToLLVM/ModuleSymbolsCache.h"
 #include "TypeScript/LowerToLLVM/TypeConverterHelper.h"
 #include "TypeScript/LowerToLLVM/TypeHelper.h"
 
@@ -34,49 +35,49 @@ class LLVMCodeHelperBase
     {
     }
 
+    // globals are top level operations only, bodies of functions (which can be converted by other threads) are not
+    // visited; symbols of the lowering pass are placed by ModuleSymbolsCache
     template <typename T> void seekLast(mlir::Block *block)
     {
+        if (getModuleSymbolsCache(block))
+        {
+            return;
+        }
+
         // find last string
-        auto lastUse = [&](Operation *op) {
-            if (auto globalOp = dyn_cast_or_null<LLVM::GlobalOp>(op))
+        for (auto globalOp : block->getOps<LLVM::GlobalOp>())
+        {
+            if (globalOp.getValueAttr() && globalOp.getValueAttr().isa<T>())
             {
-                if (globalOp.getValueAttr() && globalOp.getValueAttr().isa<T>())
-                {
-                    rewriter.setInsertionPointAfter(globalOp);
-                }
+                rewriter.setInsertionPointAfter(globalOp);
             }
-        };
-
-        block->walk(lastUse);
+        }
     }
 
     void seekLast(mlir::Block *block)
     {
-        // find last string
-        auto lastUse = [&](mlir::Operation *op) {
-            if (auto globalOp = dyn_cast_or_null<LLVM::GlobalOp>(op))
-            {
-                rewriter.setInsertionPointAfter(globalOp);
-            }
-        };
+        if (getModuleSymbolsCache(block))
+        {
+            return;
+        }
 
-        block->walk(lastUse);
+        // find last string
+        for (auto globalOp : block->getOps<LLVM::GlobalOp>())
+        {
+            rewriter.setInsertionPointAfter(globalOp);
+        }
     }
 
     void seekLastWithBody(mlir::Block *block)
     {
         // find last string
-        auto lastUse = [&](Operation *op) {
-            if (auto globalOp = dyn_cast_or_null<LLVM::GlobalOp>(op))
+        for (auto globalOp : block->getOps<LLVM::GlobalOp>())
+        {
+            if (globalOp.getInitializerBlock())
             {
-                if (globalOp.getInitializerBlock())
-                {
-                    rewriter.setInsertionPointAfter(globalOp);
-                }
+                rewriter.setInsertionPointAfter(globalOp);
             }
-        };
-
-        block->walk(lastUse);
+        }
     }
 
     template <typename T> void seekLastOp(mlir::Block *block)
@@ -120,6 +121,45 @@ class LLVMCodeHelperBase
         return foundOp;
     }
 
+    // module level symbols are taken from the cache of the lowering pass when it is running (see ModuleSymbolsCache)
+    ModuleSymbolsCache *getModuleSymbolsCache(mlir::Block *block)
+    {
+        auto cache = ModuleSymbolsCache::get(op->getParentOfType<ModuleOp>());
+        return cache && cache->getSymbolsBlock() == block ? cache : nullptr;
+    }
+
+    // symbols are created in the own module of the cache while the lowering pass is running
+    mlir::Block *getSymbolsBlock(ModuleOp parentModule)
+    {
+        if (auto cache = ModuleSymbolsCache::get(parentModule))
+        {
+            return cache->getSymbolsBlock();
+        }
+
+        return parentModule.getBody();
+    }
+
+    template <typename T> T lookupModuleSymbol(ModuleOp parentModule, StringRef name)
+    {
+        if (auto cache = ModuleSymbolsCache::get(parentModule))
+        {
+            return cache->lookupSymbol<T>(name);
+        }
+
+        return parentModule.lookupSymbol<T>(name);
+    }
+
+    // creates the symbol at the insertion point, which is in getSymbolsBlock(), by the rewriter
+    template <typename OpTy, typename... Args> OpTy createModuleSymbol(ModuleOp parentModule, mlir::Location loc, Args &&...args)
+    {
+        if (auto cache = ModuleSymbolsCache::get(parentModule))
+        {
+            return cache->createSymbol<OpTy>(rewriter, loc, std::forward<Args>(args)...);
+        }
+
+        return rewriter.create<OpTy>(loc, std::forward<Args>(args)...);
+    }
+
     std::string getStorageStringName(std::string value)
     {
         auto opHash = std::hash<std::string>{}(value);
@@ -142,15 +182,17 @@ class LLVMCodeHelperBase
 
         // Create the global at the entry of the module.
         LLVM::GlobalOp global;
-        if (!(global = parentModule.lookupSymbol<LLVM::GlobalOp>(name)))
+        if (!(global = lookupModuleSymbol<LLVM::GlobalOp>(parentModule, name)))
         {
             OpBuilder::InsertionGuard insertGuard(rewriter);
-            rewriter.setInsertionPointToStart(parentModule.getBody());
+            auto symbolsBlock = getSymbolsBlock(parentModule);
+            rewriter.setInsertionPointToStart(symbolsBlock);
 
-            seekLast<StringAttr>(parentModule.getBody());
+            seekLast<StringAttr>(symbolsBlock);
 
             auto type = th.getArrayType(th.getI8Type(), value.size());
-            global = rewriter.create<LLVM::GlobalOp>(loc, type, true, LLVM::Linkage::Internal, name, rewriter.getStringAttr(value));
+            global = createModuleSymbol<LLVM::GlobalOp>(parentModule, loc, type, true, LLVM::Linkage::Internal, name,
+                                                        rewriter.getStringAttr(value));
         }
 
         // Get the pointer to the first character in the global string.
@@ -174,7 +216,7 @@ class LLVMCodeHelperBase
     {
         auto parentModule = op->getParentOfType<ModuleOp>();
 
-        if (auto funcOp = parentModule.lookupSymbol<LLVM::LLVMFuncOp>(name))
+        if (auto funcOp = lookupModuleSymbol<LLVM::LLVMFuncOp>(parentModule, name))
         {
             return funcOp;
         }
@@ -183,8 +225,8 @@ class LLVMCodeHelperBase
 
         // Insert the printf function into the body of the parent module.
         PatternRewriter::InsertionGuard insertGuard(rewriter);
-        rewriter.setInsertionPointToStart(parentModule.getBody());
-        return rewriter.create<LLVM::LLVMFuncOp>(loc, name, llvmFnType);
+        rewriter.setInsertionPointToStart(getSymbolsBlock(parentModule));
+        return createModuleSymbol<LLVM::LLVMFuncOp>(parentModule, loc, name, llvmFnType);
     }
 
     mlir::Value MemoryAlloc(mlir::Value sizeOfAlloc, MemoryAllocSet zero = MemoryAllocSet::None)
@@ -169,8 +169,9 @@ class LLVMRTTIHelperVCWin32
 
         OpBuilder::InsertionGuard guard(rewriter);
 
-        rewriter.setInsertionPointToStart(parentModule.getBody());
-        ch.seekLast(parentModule.getBody());
+        auto symbolsBlock = ch.getSymbolsBlock(parentModule);
+        rewriter.setInsertionPointToStart(symbolsBlock);
+        ch.seekLast(symbolsBlock);
 
         // ??_7type_info@@6B@
         typeInfo(loc);
@@ -194,12 +195,13 @@ class LLVMRTTIHelperVCWin32
     LogicalResult typeInfo(mlir::Location loc)
     {
         auto name = typeInfoExtRef;
-        if (parentModule.lookupSymbol<LLVM::GlobalOp>(name))
+        if (ch.lookupModuleSymbol<LLVM::GlobalOp>(parentModule, name))
         {
             return failure();
         }
 
-        rewriter.create<LLVM::GlobalOp>(loc, th.getI8PtrType(), true, LLVM::Linkage::External, name, mlir::Attribute{});
+        ch.createModuleSymbol<LLVM::GlobalOp>(parentModule, loc, th.getI8PtrType(), true, LLVM::Linkage::External, name,
+                                              mlir::Attribute{});
         return success();
     }
 
@@ -219,14 +221,15 @@ class LLVMRTTIHelperVCWin32
     LogicalResult typeDescriptor(mlir::Location loc, StringRef typeInfoRefName, StringRef typeName)
     {
         auto name = typeInfoRefName;
-        if (parentModule.lookupSymbol<LLVM::GlobalOp>(name))
+        if (ch.lookupModuleSymbol<LLVM::GlobalOp>(parentModule, name))
         {
             return failure();
         }
 
         auto rttiTypeDescriptor2Ty = getRttiTypeDescriptor2Ty(StringRef(typeName).size());
         auto _r0n_Value =
-            rewriter.create<LLVM::GlobalOp>(loc, rttiTypeDescriptor2Ty, false, LLVM::Linkage::LinkonceODR, name, mlir::Attribute{});
+            ch.createModuleSymbol<LLVM::GlobalOp>(parentModule, loc, rttiTypeDescriptor2Ty, false, LLVM::Linkage::LinkonceODR, name,
+                                                  mlir::Attribute{});
 
         {
             ch.setStructWritingPoint(_r0n_Value);
@@ -257,12 +260,13 @@ class LLVMRTTIHelperVCWin32
     LogicalResult imageBase(mlir::Location loc)
     {
         auto name = imageBaseRef;
-        if (parentModule.lookupSymbol<LLVM::GlobalOp>(name))
+        if (ch.lookupModuleSymbol<LLVM::GlobalOp>(parentModule, name))
         {
             return failure();
         }
 
-        rewriter.create<LLVM::GlobalOp>(loc, th.getI8Type(), true, LLVM::Linkage::External, name, mlir::Attribute{});
+        ch.createModuleSymbol<LLVM::GlobalOp>(parentModule, loc, th.getI8Type(), true, LLVM::Linkage::External, name,
+                                              mlir::Attribute{});
         return success();
     }
 
@@ -282,7 +286,7 @@ class LLVMRTTIHelperVCWin32
     LogicalResult catchableType(mlir::Location loc, StringRef catchableTypeInfoRefName, StringRef typeInfoRefName, StringRef typeName)
     {
         auto name = catchableTypeInfoRefName;
-        if (parentModule.lookupSymbol<LLVM::GlobalOp>(name))
+        if (ch.lookupModuleSymbol<LLVM::GlobalOp>(parentModule, name))
         {
             return failure();
         }
@@ -290,7 +294,8 @@ class LLVMRTTIHelperVCWin32
         // _CT??_R0N@88
         auto ehCatchableTypeTy = getCatchableTypeTy();
         auto _ct_r0n_Value =
-            rewriter.create<LLVM::GlobalOp>(loc, ehCatchableTypeTy, true, LLVM::Linkage::LinkonceODR, name, mlir::Attribute{});
+            ch.createModuleSymbol<LLVM::GlobalOp>(parentModule, loc, ehCatchableTypeTy, true, LLVM::Linkage::LinkonceODR, name,
+                                                  mlir::Attribute{});
 
         {
             ch.setStructWritingPoint(_ct_r0n_Value);
@@ -366,7 +371,7 @@ class LLVMRTTIHelperVCWin32
     LogicalResult catchableArrayType(mlir::Location loc)
     {
         auto name = catchableTypeInfoArrayRef;
-        if (parentModule.lookupSymbol<LLVM::GlobalOp>(name))
+        if (ch.lookupModuleSymbol<LLVM::GlobalOp>(parentModule, name))
         {
             return failure();
         }
@@ -376,7 +381,8 @@ class LLVMRTTIHelperVCWin32
         // _CT??_R0N@88
         auto ehCatchableArrayTypeTy = getCatchableArrayTypeTy(arraySize);
         auto _cta1nValue =
-            rewriter.create<LLVM::GlobalOp>(loc, ehCatchableArrayTypeTy, true, LLVM::Linkage::LinkonceODR, name, mlir::Attribute{});
+            ch.createModuleSymbol<LLVM::GlobalOp>(parentModule, loc, ehCatchableArrayTypeTy, true, LLVM::Linkage::LinkonceODR, name,
+                                                  mlir::Attribute{});
 
         {
             ch.setStructWritingPoint(_cta1nValue);
@@ -419,7 +425,7 @@ class LLVMRTTIHelperVCWin32
     LogicalResult throwInfo(mlir::Location loc)
     {
         auto name = throwInfoRef;
-        if (parentModule.lookupSymbol<LLVM::GlobalOp>(name))
+        if (ch.lookupModuleSymbol<LLVM::GlobalOp>(parentModule, name))
         {
             return failure();
         }
@@ -427,7 +433,8 @@ class LLVMRTTIHelperVCWin32
         auto arraySize = types.size();
 
         auto throwInfoTy = getThrowInfoTy();
-        auto _TI1NValue = rewriter.create<LLVM::GlobalOp>(loc, throwInfoTy, true, LLVM::Linkage::LinkonceODR, name, mlir::Attribute{});
+        auto _TI1NValue = ch.createModuleSymbol<LLVM::GlobalOp>(parentModule, loc, throwInfoTy, true, LLVM::Linkage::LinkonceODR, name,
+                                                                mlir::Attribute{});
 
         // Throw Info
         ch.setStructWritingPoint(_TI1NValue);
@@ -0,0 +1,352 @@
+#ifndef MLIR_TYPESCRIPT_LOWERTOLLVMLOGIC_MODULESYMBOLSCACHE_H_
+#define MLIR_TYPESCRIPT_LOWERTOLLVMLOGIC_MODULESYMBOLSCACHE_H_
+
+#include "mlir/Dialect/LLVMIR/LLVMDialect.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/OwningOpRef.h"
+#include "mlir/IR/SymbolTable.h"
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringMap.h"
+
+#include <type_traits>
+
+using namespace mlir;
+
+namespace typescript
+{
+
+/// Index of the symbols of the module being lowered.
+///
+/// Lowering patterns declare runtime functions and create constant globals on each application, looking up symbols
+/// and the last global of the module by scanning it is quadratic in the size of the module. The cache is created by
+/// the pass for one conversion and is found by the helpers running on the same thread (see get).
+///
+/// The index keeps ops of the module which exist when the conversion starts only, the conversion destroys none of them
+/// before it ends. Symbols are created by the rewriter (createSymbol), so they are rolled back with their patterns,
+/// but in the own module of the cache: the conversion appends nothing else there and a rollback removes the symbols
+/// created last, so the symbols which are gone are found by comparing the end of that module with the list of created
+/// ones, without touching destroyed ops. commit moves the created symbols to the module when the conversion is done.
+///
+/// A cache of a worker converting a function in parallel with others (see createLowerToLLVMPass) also looks up symbols
+/// in the cache of the module (parent), which is not changed while workers are running.
+class ModuleSymbolsCache
+{
+  public:
+    explicit ModuleSymbolsCache(mlir::ModuleOp module, const ModuleSymbolsCache *parent = nullptr)
+        : module(module), parent(parent), symbolsModule(mlir::ModuleOp::create(module.getLoc())), previous(current())
+    {
+        index();
+        current() = this;
+    }
+
+    ~ModuleSymbolsCache()
+    {
+        current() = previous;
+    }
+
+    ModuleSymbolsCache(const ModuleSymbolsCache &) = delete;
+    ModuleSymbolsCache &operator=(const ModuleSymbolsCache &) = delete;
+
+    /// cache of the module if it is being lowered by this thread, initializers of created globals are in the own
+    /// module of the cache
+    static ModuleSymbolsCache *get(mlir::ModuleOp module)
+    {
+        auto cache = current();
+        return cache && (cache->module == module || cache->symbolsModule.get() == module) ? cache : nullptr;
+    }
+
+    /// block the symbols are created in
+    mlir::Block *getSymbolsBlock()
+    {
+        return symbolsModule->getBody();
+    }
+
+    template <typename T> T lookupSymbol(StringRef name)
+    {
+        dropRolledBackSymbols();
+
+        auto createdIt = createdSymbols.find(name);
+        if (createdIt != createdSymbols.end())
+        {
+            return dyn_cast<T>(createdIt->second);
+        }
+
+        auto it = symbols.find(name);
+        if (it != symbols.end())
+        {
+            if (auto symbolOp = dyn_cast<T>(it->second))
+            {
+                return symbolOp;
+            }
+
+            return findReplacement<T>(it->second);
+        }
+
+        if (parent)
+        {
+            if (auto symbolOp = parent->findSymbol<T>(name))
+            {
+                return symbolOp;
+            }
+        }
+
+        // constants are created by createSymbol only, declarations of functions are also created by other patterns
+        // (__mlir_gctors, createFunctionFromRegion, conversions of standard dialects), there are a few of them
+        if (!std::is_same<T, LLVM::GlobalOp>::value)
+        {
+            return module.lookupSymbol<T>(name);
+        }
+
+        return T();
+    }
+
+    /// creates the symbol by the builder (the rewriter of the pattern) at the end of getSymbolsBlock()
+    template <typename OpTy, typename... Args> OpTy createSymbol(OpBuilder &builder, mlir::Location loc, Args &&...args)
+    {
+        dropRolledBackSymbols();
+
+        OpBuilder::InsertionGuard insertGuard(builder);
+        builder.setInsertionPointToEnd(getSymbolsBlock());
+        auto symbolOp = builder.create<OpTy>(loc, std::forward<Args>(args)...);
+
+        auto name = getSymbolName(symbolOp);
+        created.push_back({symbolOp.getOperation(), name});
+        createdSymbols[name.getValue()] = symbolOp.getOperation();
+        return symbolOp;
+    }
+
+    /// moves the symbols created by the conversion to the module, call it when the conversion is done
+    LogicalResult commit()
+    {
+        created.clear();
+        createdSymbols.clear();
+
+        // ops created in the module by the conversion, ops replaced by it are erased
+        index();
+        return addSymbols(*getSymbolsBlock());
+    }
+
+    /// symbols created by the conversion of the worker, for addSymbols of the cache of the module, the worker is done
+    mlir::OwningOpRef<mlir::ModuleOp> takeSymbols()
+    {
+        created.clear();
+        createdSymbols.clear();
+        return std::move(symbolsModule);
+    }
+
+    /// moves the ops of the block to the module, symbols created by several workers (runtime functions, constants
+    /// named by their values) are added once, they must be the same
+    LogicalResult addSymbols(mlir::Block &block)
+    {
+        auto result = success();
+
+        auto body = module.getBody();
+        auto firstOp = body->empty() ? nullptr : &body->front();
+        for (auto &op : llvm::make_early_inc_range(block))
+        {
+            auto name = getSymbolName(&op);
+            auto it = name ? symbols.find(name.getValue()) : symbols.end();
+            if (it != symbols.end())
+            {
+                if (!isSameSymbol(it->second, &op))
+                {
+                    op.emitError("symbol '") << name.getValue() << "' is created with different definitions";
+                    result = failure();
+                }
+
+                op.erase();
+                continue;
+            }
+
+            if (isa<LLVM::GlobalOp>(op) && lastGlobal)
+            {
+                op.moveAfter(lastGlobal);
+            }
+            else if (firstOp)
+            {
+                op.moveBefore(firstOp);
+            }
+            else
+            {
+                op.moveBefore(body, body->end());
+            }
+
+            if (isa<LLVM::GlobalOp>(op))
+            {
+                lastGlobal = &op;
+            }
+
+            if (name)
+            {
+                symbols[name.getValue()] = &op;
+            }
+        }
+
+        return result;
+    }
+
+  private:
+    static mlir::StringAttr getSymbolName(Operation *op)
+    {
+        return op->getAttrOfType<mlir::StringAttr>(SymbolTable::getSymbolAttrName());
+    }
+
+    // parent is not changed while workers are running
+    template <typename T> T findSymbol(StringRef name) const
+    {
+        auto it = symbols.find(name);
+        return it != symbols.end() ? dyn_cast<T>(it->second) : T();
+    }
+
+    // an op replaced by the conversion (for example func.func -> llvm.func) stays in the module till the end of the
+    // conversion, the driver inserts the new op right before the op being rewritten, so replacements of the indexed op
+    // are the ops with its name in front of it (the last one first), they are not kept in the index as a rolled back
+    // pattern destroys them
+    template <typename T> static T findReplacement(Operation *indexedOp)
+    {
+        auto name = getSymbolName(indexedOp);
+        for (auto op = indexedOp->getPrevNode(); op && getSymbolName(op) == name; op = op->getPrevNode())
+        {
+            if (auto symbolOp = dyn_cast<T>(op))
+            {
+                return symbolOp;
+            }
+        }
+
+        return T();
+    }
+
+    void index()
+    {
+        symbols.clear();
+        lastGlobal = nullptr;
+        for (auto &op : *module.getBody())
+        {
+            if (auto name = getSymbolName(&op))
+            {
+                // first one wins, as in lookupSymbol
+                symbols.try_emplace(name.getValue(), &op);
+            }
+
+            if (isa<LLVM::GlobalOp>(op))
+            {
+                lastGlobal = &op;
+            }
+        }
+    }
+
+    // a rolled back pattern destroys the ops created after it has started, which are at the end of getSymbolsBlock(),
+    // created ones which are not there any more are forgotten (their pointers are compared only, never dereferenced)
+    void dropRolledBackSymbols()
+    {
+        auto block = getSymbolsBlock();
+        while (!created.empty() && (block->empty() || &block->back() != created.back().first))
+        {
+            auto it = createdSymbols.find(created.back().second.getValue());
+            if (it != createdSymbols.end() && it->second == created.back().first)
+            {
+                createdSymbols.erase(it);
+            }
+
+            created.pop_back();
+        }
+    }
+
+    // the same op name, attributes (including the symbol name, type and value) and initializer
+    static bool isSameSymbol(Operation *lhs, Operation *rhs)
+    {
+        SmallVector<Operation *> lhsOps, rhsOps;
+        lhs->walk<WalkOrder::PreOrder>([&](Operation *op) { lhsOps.push_back(op); });
+        rhs->walk<WalkOrder::PreOrder>([&](Operation *op) { rhsOps.push_back(op); });
+        if (lhsOps.size() != rhsOps.size())
+        {
+            return false;
+        }
+
+        llvm::DenseMap<mlir::Value, mlir::Value> values;
+        llvm::DenseMap<mlir::Block *, mlir::Block *> blocks;
+        for (auto [lhsOp, rhsOp] : llvm::zip(lhsOps, rhsOps))
+        {
+            if (lhsOp->getName() != rhsOp->getName() || lhsOp->getAttrDictionary() != rhsOp->getAttrDictionary() ||
+                !llvm::equal(lhsOp->getResultTypes(), rhsOp->getResultTypes()) ||
+                lhsOp->getNumOperands() != rhsOp->getNumOperands() ||
+                lhsOp->getNumSuccessors() != rhsOp->getNumSuccessors() ||
+                lhsOp->getNumRegions() != rhsOp->getNumRegions())
+            {
+                return false;
+            }
+
+            for (auto [lhsRegion, rhsRegion] : llvm::zip(lhsOp->getRegions(), rhsOp->getRegions()))
+            {
+                if (lhsRegion.getBlocks().size() != rhsRegion.getBlocks().size())
+                {
+                    return false;
+                }
+
+                for (auto [lhsBlock, rhsBlock] : llvm::zip(lhsRegion, rhsRegion))
+                {
+                    if (lhsBlock.getOperations().size() != rhsBlock.getOperations().size() ||
+                        !llvm::equal(lhsBlock.getArgumentTypes(), rhsBlock.getArgumentTypes()))
+                    {
+                        return false;
+                    }
+
+                    blocks[&lhsBlock] = &rhsBlock;
+                    for (auto [lhsArg, rhsArg] : llvm::zip(lhsBlock.getArguments(), rhsBlock.getArguments()))
+                    {
+                        values[lhsArg] = rhsArg;
+                    }
+                }
+            }
+
+            for (auto [lhsResult, rhsResult] : llvm::zip(lhsOp->getResults(), rhsOp->getResults()))
+            {
+                values[lhsResult] = rhsResult;
+            }
+        }
+
+        // operands and successors after all values are mapped, blocks are not in the order of dominance
+        for (auto [lhsOp, rhsOp] : llvm::zip(lhsOps, rhsOps))
+        {
+            for (auto [lhsOperand, rhsOperand] : llvm::zip(lhsOp->getOperands(), rhsOp->getOperands()))
+            {
+                if (values.lookup(lhsOperand) != rhsOperand)
+                {
+                    return false;
+                }
+            }
+
+            for (auto [lhsSuccessor, rhsSuccessor] : llvm::zip(lhsOp->getSuccessors(), rhsOp->getSuccessors()))
+            {
+                if (blocks.lookup(lhsSuccessor) != rhsSuccessor)
+                {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    static ModuleSymbolsCache *&current()
+    {
+        static thread_local ModuleSymbolsCache *cache = nullptr;
+        return cache;
+    }
+
+    mlir::ModuleOp module;
+    const ModuleSymbolsCache *parent;
+    mlir::OwningOpRef<mlir::ModuleOp> symbolsModule;
+    ModuleSymbolsCache *previous;
+    llvm::StringMap<Operation *> symbols;
+    Operation *lastGlobal = nullptr;
+    SmallVector<std::pair<Operation *, mlir::StringAttr>> created;
+    llvm::StringMap<Operation *> createdSymbols;
+};
+
+} // namespace typescript
+
+#endif // MLIR_TYPESCRIPT_LOWERTOLLVMLOGIC_MODULESYMBOLSCACHE_H_
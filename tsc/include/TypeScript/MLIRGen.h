@@ -3,6 +3,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "TypeScript/DataStructs.h"
 
@@ -12,6 +13,7 @@ class MLIRContext;
 template <typename OpTy>
 class OwningOpRef;
 class ModuleOp;
+class TimingScope;
 } // namespace mlir
 
 namespace llvm
@@ -21,9 +23,15 @@ class StringRef;
 
 namespace typescript
 {
+/// Keeps parsed include files between compilations in the same process (compile server), the file is parsed again
+/// only when its content is changed. Must not be shared between compilations running in parallel.
+::std::shared_ptr<IncludeFilesCache> createIncludeFilesCache();
+
 ::std::string dumpFromSource(const llvm::StringRef &fileName, const llvm::StringRef &source);
 mlir::OwningOpRef<mlir::ModuleOp> mlirGenFromSource(const mlir::MLIRContext &context, const llvm::StringRef &fileName, const llvm::StringRef &source,
-                                        CompileOptions compileOptions);
+                                        CompileOptions compileOptions, ::std::vector<::std::string> *dependencies = nullptr,
+                                        ::std::vector<::std::string> *importedModules = nullptr,
+                                        mlir::TimingScope *timingScope = nullptr);
 } // namespace typescript
 
 #endif // MLIR_TYPESCRIPT_MLIRGEN_H_
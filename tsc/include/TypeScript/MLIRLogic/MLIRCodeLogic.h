@@ -15,6 +15,7 @@
 #include "parser_types.h"
 
 #include <numeric>
+#include <set>
 
 using namespace ::typescript;
 using namespace ts;
@@ -151,14 +152,14 @@ class MLIRCustomMethods
 
     static bool isInternalObjectName (StringRef objectName)
     {
-        static std::map<std::string, bool> o { {"Symbol", true}};
-        return o[objectName.str()];    
+        static const std::set<std::string, std::less<>> o { "Symbol" };
+        return o.find(objectName) != o.end();
     }
 
     static bool isInternalFunctionName (StringRef functionName)
     {
-        static std::map<std::string, bool> m { {"print", true}, {"assert", true}, {"parseInt", true}, {"parseFloat", true}, {"isNaN", true}, {"sizeof", true}, {"switchstate", true}};
-        return m[functionName.str()];    
+        static const std::set<std::string, std::less<>> m { "print", "assert", "parseInt", "parseFloat", "isNaN", "sizeof", "switchstate" };
+        return m.find(functionName) != m.end();
     }
 
     ValueOrLogicalResult callMethod(StringRef functionName, ArrayRef<mlir::Value> operands, const GenContext &genContext)
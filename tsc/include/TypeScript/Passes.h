@@ -19,7 +19,10 @@ std::unique_ptr<mlir::Pass> createLowerToAffineModulePass();
 
 /// Create a pass for lowering operations the remaining `TypeScript` operations, as
 /// well as `Affine` and `Std`, to the LLVM dialect for codegen.
-std::unique_ptr<mlir::Pass> createLowerToLLVMPass();
+/// parallelFunctions: bodies of functions are converted in parallel (on the threads of the context)
+/// exportGlobalConstructors: __mlir_gctors (calls all global constructors) is external to be called by JIT, otherwise it
+/// is internal, so modules linked together do not define it several times
+std::unique_ptr<mlir::Pass> createLowerToLLVMPass(bool parallelFunctions = false, bool exportGlobalConstructors = false);
 
 // to move constant to root of function to avoid "dominating" issue after joining constants in "switch state"
 // TODO: should you process, switch satate in createLowerToAffinePass to resolve issue?
@@ -0,0 +1,76 @@
+#ifndef TYPESCRIPT_TIEREDJIT_H_
+#define TYPESCRIPT_TIEREDJIT_H_
+
+#include "llvm/ExecutionEngine/Orc/IndirectionUtils.h"
+#include "llvm/ExecutionEngine/Orc/LLJIT.h"
+#include "llvm/ExecutionEngine/Orc/ThreadSafeModule.h"
+#include "llvm/Support/ThreadPool.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace typescript
+{
+
+/// JIT compiling in two tiers.
+///
+/// All functions of the module are compiled quickly (tier 0) and called through indirect stubs, each tier 0 function
+/// counts its calls. When the counter reaches the threshold the function is optimized (tier 2) on the background
+/// thread and its stub is switched to the optimized code. Tier 2 module contains only the hot function, all other
+/// functions and globals are resolved to the tier 0 module (local symbols are promoted to hidden ones for that).
+class TieredJit
+{
+  public:
+    using TransformerT = std::function<llvm::Error(llvm::Module *)>;
+
+    static llvm::Expected<std::unique_ptr<TieredJit>> create(unsigned threshold, TransformerT tier0Transformer,
+                                                             TransformerT tier2Transformer);
+
+    /// waits for running background compilations
+    ~TieredJit();
+
+    llvm::orc::LLJIT &getJIT()
+    {
+        return *jit;
+    }
+
+    /// compiles tier 0 of all functions, functions can be looked up by original names after it
+    llvm::Error addModule(llvm::orc::ThreadSafeModule threadSafeModule);
+
+    /// number of functions recompiled in tier 2
+    unsigned getTier2Count()
+    {
+        return tier2Count;
+    }
+
+  private:
+    TieredJit(unsigned threshold, TransformerT tier0Transformer, TransformerT tier2Transformer);
+
+    llvm::Error prepareModule(llvm::Module &module);
+    void instrumentFunction(llvm::Function &function, unsigned index);
+    void recompile(unsigned index);
+
+    static void tierUp(TieredJit *tieredJit, int64_t index);
+
+    unsigned threshold;
+    TransformerT tier0Transformer;
+    TransformerT tier2Transformer;
+
+    std::unique_ptr<llvm::orc::LLJIT> jit;
+    std::unique_ptr<llvm::orc::IndirectStubsManager> stubsManager;
+
+    // unoptimized module to extract hot functions from
+    llvm::SmallVector<char, 0> moduleBitcode;
+    std::vector<std::string> functionNames;
+    std::atomic<unsigned> tier2Count{0};
+
+    // destroyed first, so background compilations are finished before JIT is destroyed
+    std::unique_ptr<llvm::ThreadPool> backgroundCompilation;
+};
+
+} // namespace typescript
+
+#endif // TYPESCRIPT_TIEREDJIT_H_
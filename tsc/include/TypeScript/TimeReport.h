@@ -0,0 +1,50 @@
+#ifndef TYPESCRIPT_TIMEREPORT_H_
+#define TYPESCRIPT_TIMEREPORT_H_
+
+#include "mlir/Support/Timing.h"
+
+#include "llvm/Support/raw_ostream.h"
+
+#include <memory>
+#include <mutex>
+
+namespace typescript
+{
+
+enum class TimeReportFormat
+{
+    Text,
+    Json
+};
+
+/// Timing manager to collect wall time, CPU time and peak RSS of each phase of compilation.
+///
+/// Phases are nested timing scopes (see mlir::TimingScope), passes of the MLIR pipeline are nested into the phase
+/// scope by PassManager::enableTiming.
+class TimeReportManager : public mlir::TimingManager
+{
+  public:
+    TimeReportManager();
+    ~TimeReportManager() override;
+
+    void print(llvm::raw_ostream &os, TimeReportFormat format);
+
+  protected:
+    llvm::Optional<void *> rootTimer() override;
+    void startTimer(void *handle) override;
+    void stopTimer(void *handle) override;
+    void *nestTimer(void *handle, const void *id, llvm::function_ref<std::string()> nameBuilder) override;
+
+  private:
+    struct TimerNode;
+
+    std::unique_ptr<TimerNode> root;
+    std::mutex mutex;
+};
+
+/// peak resident set size of the process in bytes
+size_t getPeakRSS();
+
+} // namespace typescript
+
+#endif // TYPESCRIPT_TIMEREPORT_H_
@@ -19,6 +19,7 @@
 #include "mlir/Dialect/Affine/IR/AffineOps.h"
 #include "mlir/Dialect/LLVMIR/LLVMDialect.h"
 #include "mlir/Dialect/Math/IR/Math.h"
+#include "mlir/IR/Threading.h"
 
 #ifdef ENABLE_ASYNC
 #include "mlir/Conversion/AsyncToLLVM/AsyncToLLVM.h"
@@ -51,6 +52,9 @@ namespace
 struct TsLlvmContext
 {
     TsLlvmContext() = default;
+
+    // __mlir_gctors is looked up by JIT
+    bool exportGlobalConstructors = false;
 };
 
 template <typename OpTy> class TsLlvmPattern : public OpConversionPattern<OpTy>
@@ -2747,7 +2751,7 @@ struct AddressOfOpLowering : public TsLlvmPattern<mlir_ts::AddressOfOp>
             // load type from symbol
             auto module = addressOfOp->getParentOfType<mlir::ModuleOp>();
             assert(module);
-            auto globalOp = module.lookupSymbol<LLVM::GlobalOp>(addressOfOp.global_name());
+            auto globalOp = lch.lookupModuleSymbol<LLVM::GlobalOp>(module, addressOfOp.global_name());
             if (!globalOp)
             {
                 LLVM_DEBUG(llvm::dbgs() << "\n!! NOT found symbol: " << addressOfOp.global_name() << "\n";);
@@ -4303,7 +4307,7 @@ struct GlobalConstructorOpLowering : public TsLlvmPattern<mlir_ts::GlobalConstru
         mlir::Location loc = globalConstructorOp->getLoc();
 
         auto parentModule = globalConstructorOp->getParentOfType<ModuleOp>();
-        if (!parentModule.lookupSymbol<LLVM::GlobalOp>(GLOBAL_CONSTUCTIONS_NAME))
+        if (!lch.lookupModuleSymbol<LLVM::GlobalOp>(parentModule, GLOBAL_CONSTUCTIONS_NAME))
         {
             SmallVector<mlir_ts::GlobalConstructorOp, 4> globalConstructs;
             auto visitorAllGlobalConstructs = [&](Operation *op) {
@@ -4383,7 +4387,10 @@ struct GlobalConstructorOpLowering : public TsLlvmPattern<mlir_ts::GlobalConstru
                 // create __mlir_runner_init for JIT
                 rewriter.setInsertionPointToEnd(parentModule.getBody());
                 auto llvmFnType = LLVM::LLVMFunctionType::get(th.getVoidType(), {}, /*isVarArg=*/false);
-                auto initFunc = rewriter.create<LLVM::LLVMFuncOp>(loc, "__mlir_gctors", llvmFnType);
+                // each module has its own one, imported modules are linked with their importers
+                auto linkage =
+                    tsLlvmContext->exportGlobalConstructors ? LLVM::Linkage::External : LLVM::Linkage::Internal;
+                auto initFunc = rewriter.create<LLVM::LLVMFuncOp>(loc, "__mlir_gctors", llvmFnType, linkage);
                 auto &entryBlock = *initFunc.addEntryBlock();
                 rewriter.setInsertionPointToEnd(&entryBlock);
 
@@ -4876,6 +4883,11 @@ struct TypeScriptToLLVMLoweringPass : public PassWrapper<TypeScriptToLLVMLowerin
 {
     MLIR_DEFINE_EXPLICIT_INTERNAL_INLINE_TYPE_ID(TypeScriptToLLVMLoweringPass)
 
+    TypeScriptToLLVMLoweringPass(bool parallelFunctions = false, bool exportGlobalConstructors = false)
+        : parallelFunctions(parallelFunctions), exportGlobalConstructors(exportGlobalConstructors)
+    {
+    }
+
     void getDependentDialects(DialectRegistry &registry) const override
     {
         registry.insert<
@@ -4887,6 +4899,12 @@ struct TypeScriptToLLVMLoweringPass : public PassWrapper<TypeScriptToLLVMLowerin
     }
 
     void runOnOperation() final;
+
+  private:
+    LogicalResult convertFunctionsInParallel(mlir::SetVector<mlir::Type> &stack);
+
+    bool parallelFunctions;
+    bool exportGlobalConstructors;
 };
 
 } // end anonymous namespace
@@ -5081,33 +5099,11 @@ static LogicalResult cleanupUnrealizedConversionCast(mlir::ModuleOp &module)
     return success();
 }
 
-void TypeScriptToLLVMLoweringPass::runOnOperation()
+static void populateLowerToLLVMPatterns(LLVMTypeConverter &typeConverter, LLVMConversionTarget &target,
+                                        RewritePatternSet &patterns, TsLlvmContext *tsLlvmContext)
 {
-    auto m = getOperation();
+    auto context = patterns.getContext();
 
-    // The first thing to define is the conversion target. This will define the
-    // final target for this lowering. For this lowering, we are only targeting
-    // the LLVM dialect.
-    LLVMConversionTarget target(getContext());
-    target.addLegalOp<ModuleOp>();
-    target.addLegalOp<mlir_ts::GlobalConstructorOp>();
-
-    // During this lowering, we will also be lowering the MemRef types, that are
-    // currently being operated on, to a representation in LLVM. To perform this
-    // conversion we use a TypeConverter as part of the lowering. This converter
-    // details how one type maps to another. This is necessary now that we will be
-    // doing more complicated lowerings, involving loop region arguments.
-    LLVMTypeConverter typeConverter(&getContext());
-
-    // Now that the conversion target has been defined, we need to provide the
-    // patterns used for lowering. At this point of the compilation process, we
-    // have a combination of `typescript`, `affine`, and `std` operations. Luckily, there
-    // are already exists a set of patterns to transform `affine` and `std`
-    // dialects. These patterns lowering in multiple stages, relying on transitive
-    // lowerings. Transitive lowering, or A->B->C lowering, is when multiple
-    // patterns must be applied to fully transform an illegal operation into a
-    // set of legal ones.
-    RewritePatternSet patterns(&getContext());
     populateAffineToStdConversionPatterns(patterns);
     arith::populateArithmeticToLLVMConversionPatterns(typeConverter, patterns);
     cf::populateControlFlowToLLVMConversionPatterns(typeConverter, patterns);
@@ -5119,7 +5115,6 @@ void TypeScriptToLLVMLoweringPass::runOnOperation()
 #endif
 
     // The only remaining operation to lower from the `typescript` dialect, is the PrintOp.
-    TsLlvmContext tsLlvmContext{};
     patterns.insert<
         AddressOfOpLowering, AddressOfConstStringOpLowering, ArithmeticUnaryOpLowering, ArithmeticBinaryOpLowering,
         AssertOpLowering, CastOpLowering, ConstantOpLowering, CreateOptionalOpLowering, UndefOptionalOpLowering,
@@ -5148,12 +5143,148 @@ void TypeScriptToLLVMLoweringPass::runOnOperation()
         SwitchStateOpLowering, StateLabelOpLowering, YieldReturnValOpLowering
 #endif
         ,
-        SwitchStateInternalOpLowering>(typeConverter, &getContext(), &tsLlvmContext);
+        SwitchStateInternalOpLowering>(typeConverter, context, tsLlvmContext);
 
 #ifdef ENABLE_TYPED_GC
     patterns.insert<
-        GCMakeDescriptorOpLowering, GCNewExplicitlyTypedOpLowering>(typeConverter, &getContext(), &tsLlvmContext);
+        GCMakeDescriptorOpLowering, GCNewExplicitlyTypedOpLowering>(typeConverter, context, tsLlvmContext);
 #endif        
+}
+
+// operations of function bodies are left for the conversion of each function
+static bool isInsideFunction(Operation *op)
+{
+    return op->getParentOfType<LLVM::LLVMFuncOp>() || op->getParentOfType<mlir::func::FuncOp>() ||
+           op->getParentOfType<mlir_ts::FuncOp>();
+}
+
+// each function is converted in a module of its own, so nothing patterns create at the module level (symbols of
+// ModuleSymbolsCache, ops other patterns insert into the module) is shared between threads, these ops are added to the
+// module when all functions are done
+LogicalResult TypeScriptToLLVMLoweringPass::convertFunctionsInParallel(mlir::SetVector<mlir::Type> &stack)
+{
+    auto module = getOperation();
+
+    SmallVector<LLVM::LLVMFuncOp> funcs;
+    for (auto funcOp : module.getOps<LLVM::LLVMFuncOp>())
+    {
+        if (!funcOp.isExternal())
+        {
+            funcs.push_back(funcOp);
+        }
+    }
+
+    if (funcs.empty())
+    {
+        return success();
+    }
+
+    // symbols of the module are looked up in its cache, it is created while the functions are still in the module, so
+    // workers find the other functions in it instead of declaring them, the index is not changed until all functions
+    // are done
+    ModuleSymbolsCache symbolsCache(module);
+
+    SmallVector<Operation *> nextOps;
+    SmallVector<mlir::OwningOpRef<mlir::ModuleOp>> funcModules;
+    for (auto funcOp : funcs)
+    {
+        nextOps.push_back(funcOp->getNextNode());
+
+        auto funcModule = mlir::ModuleOp::create(module.getLoc());
+        funcModule->setAttrs(module->getAttrDictionary());
+        funcOp->moveBefore(funcModule.getBody(), funcModule.getBody()->end());
+        funcModules.emplace_back(funcModule);
+    }
+
+    SmallVector<mlir::OwningOpRef<mlir::ModuleOp>> funcSymbols(funcs.size());
+    auto result = failableParallelForEachN(&getContext(), 0, funcs.size(), [&](size_t index) {
+        LLVMConversionTarget target(getContext());
+        target.addLegalOp<ModuleOp>();
+        target.addLegalOp<mlir_ts::GlobalConstructorOp>();
+
+        // patterns and type converter are not shared between threads
+        LLVMTypeConverter typeConverter(&getContext());
+        RewritePatternSet patterns(&getContext());
+        TsLlvmContext tsLlvmContext{};
+        populateLowerToLLVMPatterns(typeConverter, target, patterns, &tsLlvmContext);
+
+        // identified structs are already created by the module conversion
+        auto funcModule = funcModules[index].get();
+        mlir::SetVector<mlir::Type> funcStack(stack.begin(), stack.end());
+        populateTypeScriptConversionPatterns(typeConverter, funcModule, funcStack);
+
+        ModuleSymbolsCache funcSymbolsCache(funcModule, &symbolsCache);
+        if (failed(applyFullConversion(funcs[index], target, std::move(patterns))))
+        {
+            return failure();
+        }
+
+        funcSymbols[index] = funcSymbolsCache.takeSymbols();
+        return success();
+    });
+
+    // back to their places, the last one first as the next op of a function can be the next function
+    for (auto index = funcs.size(); index-- > 0;)
+    {
+        if (nextOps[index])
+        {
+            funcs[index]->moveBefore(nextOps[index]);
+        }
+        else
+        {
+            funcs[index]->moveBefore(module.getBody(), module.getBody()->end());
+        }
+    }
+
+    if (failed(result))
+    {
+        return failure();
+    }
+
+    // symbols created for several functions (runtime functions, constants named by their values) are added once, the
+    // cache checks that they are the same
+    for (auto index : llvm::seq<size_t>(0, funcs.size()))
+    {
+        if (failed(symbolsCache.addSymbols(*funcSymbols[index]->getBody())) ||
+            failed(symbolsCache.addSymbols(*funcModules[index]->getBody())))
+        {
+            result = failure();
+        }
+    }
+
+    return result;
+}
+
+void TypeScriptToLLVMLoweringPass::runOnOperation()
+{
+    auto m = getOperation();
+
+    // The first thing to define is the conversion target. This will define the
+    // final target for this lowering. For this lowering, we are only targeting
+    // the LLVM dialect.
+    LLVMConversionTarget target(getContext());
+    target.addLegalOp<ModuleOp>();
+    target.addLegalOp<mlir_ts::GlobalConstructorOp>();
+
+    // During this lowering, we will also be lowering the MemRef types, that are
+    // currently being operated on, to a representation in LLVM. To perform this
+    // conversion we use a TypeConverter as part of the lowering. This converter
+    // details how one type maps to another. This is necessary now that we will be
+    // doing more complicated lowerings, involving loop region arguments.
+    LLVMTypeConverter typeConverter(&getContext());
+
+    // Now that the conversion target has been defined, we need to provide the
+    // patterns used for lowering. At this point of the compilation process, we
+    // have a combination of `typescript`, `affine`, and `std` operations. Luckily, there
+    // are already exists a set of patterns to transform `affine` and `std`
+    // dialects. These patterns lowering in multiple stages, relying on transitive
+    // lowerings. Transitive lowering, or A->B->C lowering, is when multiple
+    // patterns must be applied to fully transform an illegal operation into a
+    // set of legal ones.
+    RewritePatternSet patterns(&getContext());
+    TsLlvmContext tsLlvmContext{};
+    tsLlvmContext.exportGlobalConstructors = exportGlobalConstructors;
+    populateLowerToLLVMPatterns(typeConverter, target, patterns, &tsLlvmContext);
 
     mlir::SetVector<mlir::Type> stack;
     populateTypeScriptConversionPatterns(typeConverter, m, stack);
@@ -5164,7 +5295,22 @@ void TypeScriptToLLVMLoweringPass::runOnOperation()
 
     LLVM_DEBUG(llvm::dbgs() << "\n!! BEFORE DUMP: \n" << module << "\n";);
 
-    if (failed(applyFullConversion(module, target, std::move(patterns))))
+    if (parallelFunctions)
+    {
+        // module level operations (globals, signatures of functions) first, then bodies of functions in parallel
+        target.markUnknownOpDynamicallyLegal(isInsideFunction);
+    }
+
+    {
+        // symbols are cached for one conversion only, ops replaced by the conversion are destroyed at its end
+        ModuleSymbolsCache symbolsCache(module);
+        if (failed(applyFullConversion(module, target, std::move(patterns))) || failed(symbolsCache.commit()))
+        {
+            signalPassFailure();
+        }
+    }
+
+    if (parallelFunctions && failed(convertFunctionsInParallel(stack)))
     {
         signalPassFailure();
     }
@@ -5175,9 +5321,12 @@ void TypeScriptToLLVMLoweringPass::runOnOperation()
     RewritePatternSet patterns2(&getContext());
     patterns2.insert<GlobalConstructorOpLowering, DialectCastOpLowering>(typeConverter, &getContext(), &tsLlvmContext);
 
-    if (failed(applyFullConversion(module, target2, std::move(patterns2))))
     {
-        signalPassFailure();
+        ModuleSymbolsCache symbolsCache(module);
+        if (failed(applyFullConversion(module, target2, std::move(patterns2))) || failed(symbolsCache.commit()))
+        {
+            signalPassFailure();
+        }
     }
 
     /*
@@ -5193,7 +5342,7 @@ void TypeScriptToLLVMLoweringPass::runOnOperation()
 
 /// Create a pass for lowering operations the remaining `TypeScript` operations, as
 /// well as `Affine` and `Std`, to the LLVM dialect for codegen.
-std::unique_ptr<mlir::Pass> mlir::typescript::createLowerToLLVMPass()
+std::unique_ptr<mlir::Pass> mlir::typescript::createLowerToLLVMPass(bool parallelFunctions, bool exportGlobalConstructors)
 {
-    return std::make_unique<TypeScriptToLLVMLoweringPass>();
+    return std::make_unique<TypeScriptToLLVMLoweringPass>(parallelFunctions, exportGlobalConstructors);
 }
@@ -41,7 +41,10 @@
 #include "mlir/IR/Diagnostics.h"
 #include "mlir/IR/MLIRContext.h"
 #include "mlir/IR/Types.h"
+#include "mlir/IR/SymbolTable.h"
+#include "mlir/IR/Threading.h"
 #include "mlir/IR/Verifier.h"
+#include "mlir/Support/Timing.h"
 
 #include "mlir/Dialect/ControlFlow/IR/ControlFlowOps.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
@@ -53,8 +56,10 @@
 #endif
 
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/TypeSwitch.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/raw_ostream.h"
@@ -77,6 +82,49 @@ using llvm::SmallVector;
 using llvm::StringRef;
 using llvm::Twine;
 
+namespace typescript
+{
+class IncludeFilesCache
+{
+  public:
+    SourceFile lookup(StringRef fullPath, StringRef refFileName, StringRef source)
+    {
+        auto it = entries.find(fullPath);
+        if (it == entries.end() || it->second.refFileName != refFileName || it->second.source != source)
+        {
+            return SourceFile();
+        }
+
+        return it->second.sourceFile;
+    }
+
+    void store(StringRef fullPath, StringRef refFileName, StringRef source, SourceFile sourceFile)
+    {
+        // file with parse errors is reported every time, do not keep it
+        if (!sourceFile->parseDiagnostics.empty())
+        {
+            entries.erase(fullPath);
+            return;
+        }
+
+        auto &entry = entries[fullPath];
+        entry.refFileName = refFileName.str();
+        entry.source = source.str();
+        entry.sourceFile = sourceFile;
+    }
+
+  private:
+    struct Entry
+    {
+        std::string refFileName;
+        std::string source;
+        SourceFile sourceFile;
+    };
+
+    llvm::StringMap<Entry> entries;
+};
+} // namespace typescript
+
 // TODO: optimize of amount of calls to detect return types and if it is was calculated before then do not run it all
 // the time
 
@@ -161,53 +209,52 @@ class MLIRGenImpl
 
     std::pair<SourceFile, std::vector<SourceFile>> loadSourceFile(StringRef fileName, StringRef source)
     {
-        std::vector<SourceFile> includeFiles;
-        std::vector<string> filesToProcess;
-
         Parser parser;
-        auto sourceFile = parser.parseSourceFile(stows(fileName.str()), stows(source.str()), ScriptTarget::Latest);
+        // the source (memory mapped file) is decoded directly, the parser and the scanner do not copy the text
+        auto sourceFile =
+            parser.parseSourceFile(stows(fileName.str()), stows(source.data(), source.size()), ScriptTarget::Latest);
+
+        // the graph of includes is loaded level by level: files referenced by the files of the level are read, then
+        // parsed in parallel
+        std::vector<IncludeFileNode> includeFileNodes;
+        llvm::StringMap<int> includeFileIndices;
+        std::vector<int> references;
         for (auto refFile : sourceFile->referencedFiles)
         {
-            filesToProcess.push_back(refFile.fileName);
+            references.push_back(addIncludeFile(refFile.fileName, includeFileNodes, includeFileIndices));
         }
 
-        while (filesToProcess.size() > 0)
+        size_t levelStart = 0;
+        while (levelStart < includeFileNodes.size())
         {
-            string includeFileName = filesToProcess.back();
-            std::string includeFileNameChar = wstos(includeFileName);
-            mlir::StringRef refFileName(includeFileNameChar);
-            SmallString<128> fullPath = path;
-            sys::path::append(fullPath, refFileName);
-
-            filesToProcess.pop_back();
-
-            auto fileOrErr = llvm::MemoryBuffer::getFileOrSTDIN(fullPath);
-            if (std::error_code ec = fileOrErr.getError())
+            auto levelEnd = includeFileNodes.size();
+            parseIncludeFiles(llvm::makeMutableArrayRef(includeFileNodes).slice(levelStart, levelEnd - levelStart));
+            for (auto index = levelStart; index < levelEnd; index++)
             {
-                emitError(mlir::UnknownLoc::get(builder.getContext()))
-                    << "Could not open file: '" << refFileName << "' Error:" << ec.message() << "\n";
-                continue;
+                auto includeFile = includeFileNodes[index].sourceFile;
+                for (auto refFile : includeFile->referencedFiles)
+                {
+                    auto refIndex = addIncludeFile(refFile.fileName, includeFileNodes, includeFileIndices);
+                    includeFileNodes[index].references.push_back(refIndex);
+                }
             }
 
-            auto includeSource = fileOrErr.get()->getBuffer();
-
-            Parser parser;
-            auto includeFile =
-                parser.parseSourceFile(stows(refFileName.str()), stows(includeSource.str()), ScriptTarget::Latest);
-            for (auto refFile : includeFile->referencedFiles)
-            {
-                filesToProcess.push_back(refFile.fileName);
-            }
+            levelStart = levelEnd;
+        }
 
-            includeFiles.push_back(includeFile);
+        std::vector<SourceFile> includeFiles;
+        for (auto index : references)
+        {
+            orderIncludeFiles(index, includeFileNodes, includeFiles);
         }
 
-        std::reverse(includeFiles.begin(), includeFiles.end());
+        loadedSourceFiles.push_back(sourceFile);
+        loadedSourceFiles.insert(loadedSourceFiles.end(), includeFiles.begin(), includeFiles.end());
 
         return {sourceFile, includeFiles};
     }
 
-    mlir::ModuleOp mlirGenSourceFile(SourceFile module, std::vector<SourceFile> includeFiles)
+    mlir::ModuleOp mlirGenSourceFile(SourceFile module, std::vector<SourceFile> includeFiles, mlir::TimingScope &timing)
     {
         if (mlir::failed(report(module, includeFiles)))
         {
@@ -232,8 +279,16 @@ class MLIRGenImpl
         llvm::ScopedHashTableScope<StringRef, GenericInterfaceInfo::TypePtr> fullNameGenericInterfacesMapScope(
             fullNameGenericInterfacesMap);
 
-        if (mlir::succeeded(mlirDiscoverAllDependencies(module, includeFiles)) &&
-            mlir::succeeded(mlirCodeGenModule(module, includeFiles)))
+        auto discoverTiming = timing.nest("Discover Dependencies");
+        if (mlir::failed(mlirDiscoverAllDependencies(module, includeFiles)))
+        {
+            return nullptr;
+        }
+
+        discoverTiming.stop();
+
+        auto codeGenTiming = timing.nest("Code Generation");
+        if (mlir::succeeded(mlirCodeGenModule(module, includeFiles)))
         {
             return theModule;
         }
@@ -241,7 +296,132 @@ class MLIRGenImpl
         return nullptr;
     }
 
+    /// files (includes and imports) loaded to compile the module
+    const std::vector<std::string> &getDependencies()
+    {
+        return dependencies;
+    }
+
+    /// imported files, only declarations are generated for them, code is compiled separately
+    const std::vector<std::string> &getImportedModules()
+    {
+        return importedModules;
+    }
+
   private:
+    /// include file (/// <reference path="..." />) in the graph of includes of the main file
+    struct IncludeFileNode
+    {
+        std::string refFileName;
+        SmallString<128> fullPath;
+        std::unique_ptr<llvm::MemoryBuffer> buffer;
+        SourceFile sourceFile;
+        // indices of the referenced files, -1 for a file which can't be read
+        std::vector<int> references;
+        bool visiting = false;
+        bool visited = false;
+    };
+
+    /// Index of the include file in the graph, the file is added (and read) when it is referenced first time. Paths are
+    /// canonicalized, the file referenced by different paths is loaded once. -1 if the file can't be read.
+    int addIncludeFile(const string &includeFileName, std::vector<IncludeFileNode> &includeFileNodes,
+                       llvm::StringMap<int> &includeFileIndices)
+    {
+        auto refFileName = wstos(includeFileName);
+        SmallString<128> fullPath = path;
+        sys::path::append(fullPath, refFileName);
+        sys::path::remove_dots(fullPath, /*remove_dot_dot*/ true);
+
+        SmallString<128> canonicalPath;
+        if (sys::fs::real_path(fullPath, canonicalPath))
+        {
+            canonicalPath = fullPath;
+        }
+
+        auto inserted = includeFileIndices.try_emplace(canonicalPath, -1);
+        if (!inserted.second)
+        {
+            return inserted.first->second;
+        }
+
+        auto fileOrErr = llvm::MemoryBuffer::getFileOrSTDIN(fullPath);
+        if (std::error_code ec = fileOrErr.getError())
+        {
+            emitError(mlir::UnknownLoc::get(builder.getContext()))
+                << "Could not open file: '" << refFileName << "' Error:" << ec.message() << "\n";
+            return -1;
+        }
+
+        dependencies.push_back(fullPath.str().str());
+
+        inserted.first->second = includeFileNodes.size();
+        includeFileNodes.push_back({refFileName, fullPath, std::move(fileOrErr.get())});
+        return inserted.first->second;
+    }
+
+    /// parses the include files in parallel, files found in the cache of include files are not parsed again
+    void parseIncludeFiles(llvm::MutableArrayRef<IncludeFileNode> includeFileNodes)
+    {
+        auto includeFilesCache = compileOptions.includeFilesCache.get();
+
+        SmallVector<IncludeFileNode *> filesToParse;
+        for (auto &includeFileNode : includeFileNodes)
+        {
+            if (includeFilesCache)
+            {
+                if (auto includeFile = includeFilesCache->lookup(
+                        includeFileNode.fullPath, includeFileNode.refFileName, includeFileNode.buffer->getBuffer()))
+                {
+                    // reset state left by previous compilation
+                    clearState(includeFile);
+                    includeFileNode.sourceFile = includeFile;
+                    continue;
+                }
+            }
+
+            filesToParse.push_back(&includeFileNode);
+        }
+
+        // parsers do not share state, nodes of each file are allocated in the arena of the file
+        mlir::parallelForEach(builder.getContext(), filesToParse, [&](IncludeFileNode *includeFileNode) {
+            Parser parser;
+            auto includeSource = includeFileNode->buffer->getBuffer();
+            includeFileNode->sourceFile =
+                parser.parseSourceFile(stows(includeFileNode->refFileName),
+                                       stows(includeSource.data(), includeSource.size()), ScriptTarget::Latest);
+        });
+
+        if (includeFilesCache)
+        {
+            for (auto includeFileNode : filesToParse)
+            {
+                includeFilesCache->store(includeFileNode->fullPath, includeFileNode->refFileName,
+                                         includeFileNode->buffer->getBuffer(), includeFileNode->sourceFile);
+            }
+        }
+    }
+
+    /// Include files are ordered for code generation in the order of references (the same for any number of threads),
+    /// a file follows the files it references. A reference back to a file being visited closes a cycle and is skipped.
+    void orderIncludeFiles(int index, std::vector<IncludeFileNode> &includeFileNodes,
+                           std::vector<SourceFile> &includeFiles)
+    {
+        if (index < 0 || includeFileNodes[index].visiting || includeFileNodes[index].visited)
+        {
+            return;
+        }
+
+        includeFileNodes[index].visiting = true;
+        for (auto refIndex : includeFileNodes[index].references)
+        {
+            orderIncludeFiles(refIndex, includeFileNodes, includeFiles);
+        }
+
+        includeFileNodes[index].visiting = false;
+        includeFileNodes[index].visited = true;
+        includeFiles.push_back(includeFileNodes[index].sourceFile);
+    }
+
     mlir::LogicalResult mlirGenCodeGenInit(SourceFile module)
     {
         sourceFile = module;
@@ -576,6 +756,31 @@ class MLIRGenImpl
         }
     }
 
+    /// clears 'processed' marks of all nodes of the file, nested nodes (class members, heritage clauses etc.) are
+    /// marked as well
+    void clearState(SourceFile file)
+    {
+        FuncT<> visitNode;
+        ArrayFuncT<> visitArray;
+
+        visitNode = [&](Node node) -> Node {
+            node->processed = false;
+            forEachChild(node, visitNode, visitArray);
+            return undefined;
+        };
+
+        visitArray = [&](NodeArray<Node> &array) -> Node {
+            for (auto node : array)
+            {
+                visitNode(node);
+            }
+
+            return undefined;
+        };
+
+        forEachChild(file.as<Node>(), visitNode, visitArray);
+    }
+
     mlir::LogicalResult mlirGen(NodeArray<Statement> statements, const GenContext &genContext)
     {
         SymbolTableScopeT varScope(symbolTable);
@@ -4794,6 +4999,18 @@ class MLIRGenImpl
         return mlir::success();
     }
 
+    /// copy of the declaration of the loop variable with the new initializer, nodes of the source file are not changed
+    /// as they can be compiled again (see IncludeFilesCache)
+    VariableDeclarationList withLoopVariableInitializer(NodeFactory &nf, VariableDeclarationList varDeclList,
+                                                        Expression initializer)
+    {
+        auto varDecl = varDeclList->declarations.front();
+        NodeArray<VariableDeclaration> declarations;
+        declarations.push_back(nf.update(
+            nf.createVariableDeclaration(varDecl->name, varDecl->exclamationToken, varDecl->type, initializer), varDecl));
+        return nf.update(nf.createVariableDeclarationList(declarations, varDeclList->flags), varDeclList);
+    }
+
     mlir::LogicalResult mlirGen(ForInStatement forInStatementAST, const GenContext &genContext)
     {
         SymbolTableScopeT varScope(symbolTable);
@@ -4826,8 +5043,8 @@ class MLIRGenImpl
         // block
         NodeArray<ts::Statement> statements;
 
-        auto varDeclList = forInStatementAST->initializer.as<VariableDeclarationList>();
-        varDeclList->declarations.front()->initializer = _i;
+        auto varDeclList =
+            withLoopVariableInitializer(nf, forInStatementAST->initializer.as<VariableDeclarationList>(), _i);
 
         statements.push_back(nf.createVariableStatement(undefined, varDeclList));
         statements.push_back(forInStatementAST->statement);
@@ -4880,8 +5097,8 @@ class MLIRGenImpl
         varOfConstDeclarations.push_back(nf.createVariableDeclaration(_ci, undefined, undefined, _i));
         auto varsOfConst = nf.createVariableDeclarationList(varOfConstDeclarations, NodeFlags::Const);
 
-        auto varDeclList = forOfStatementAST->initializer.as<VariableDeclarationList>();
-        varDeclList->declarations.front()->initializer = nf.createElementAccessExpression(_a, _ci);
+        auto varDeclList = withLoopVariableInitializer(nf, forOfStatementAST->initializer.as<VariableDeclarationList>(),
+                                                       nf.createElementAccessExpression(_a, _ci));
 
         auto initVars = nf.createVariableDeclarationList(declarations, NodeFlags::Let /*varDeclList->flags*/);
 
@@ -4946,8 +5163,8 @@ class MLIRGenImpl
         // block
         NodeArray<ts::Statement> statements;
 
-        auto varDeclList = forOfStatementAST->initializer.as<VariableDeclarationList>();
-        varDeclList->declarations.front()->initializer = nf.createPropertyAccessExpression(_c, _value);
+        auto varDeclList = withLoopVariableInitializer(nf, forOfStatementAST->initializer.as<VariableDeclarationList>(),
+                                                       nf.createPropertyAccessExpression(_c, _value));
 
         auto initVars = nf.createVariableDeclarationList(declarations, NodeFlags::Let /*varDeclList->flags*/);
 
@@ -10324,14 +10541,8 @@ class MLIRGenImpl
 
     std::string className(ClassLikeDeclaration classDeclarationAST, const GenContext &genContext)
     {
-        auto name = getNameWithArguments(classDeclarationAST, genContext);
-        if (classDeclarationAST == SyntaxKind::ClassExpression)
-        {
-            NodeFactory nf(NodeFactoryFlags::None);
-            classDeclarationAST->name = nf.createIdentifier(stows(name));
-        }
-
-        return name;
+        // the name of class expression is not stored in the node, the name made of its location is the same each time
+        return getNameWithArguments(classDeclarationAST, genContext);
     }
 
     ClassInfo::TypePtr mlirGenClassInfo(ClassLikeDeclaration classDeclarationAST, const GenContext &genContext)
@@ -15471,6 +15682,17 @@ genContext);
     }
 
   protected:
+    // locations of positions in source files, line starts of a file are computed once (kept in the source file)
+    struct SourceLocations
+    {
+        ts::SourceFile sourceFile;
+        mlir::StringAttr fileId;
+        const std::vector<number> *lineStarts = nullptr;
+        // line of the last found position
+        size_t line = 0;
+        llvm::DenseMap<int, mlir::FileLineColLoc> locations;
+    };
+
     /// Helper conversion for a TypeScript AST location to an MLIR location.
     mlir::Location loc(TextRange loc)
     {
@@ -15480,26 +15702,62 @@ genContext);
         }
 
         auto pos = loc->pos.textPos != -1 ? loc->pos.textPos : loc->pos.pos;
-        return loc2(sourceFile, fileName.str(), pos, loc->_end - pos);
+        return loc2(sourceFile, fileName, pos, loc->_end - pos);
     }
 
-    mlir::Location loc2(ts::SourceFile sourceFile, std::string fileName, int start, int length)
+    mlir::Location loc2(ts::SourceFile sourceFile, StringRef fileName, int start, int length)
     {
-        auto fileId = getStringAttr(fileName);
-        auto posLineChar = parser.getLineAndCharacterOfPosition(sourceFile, start);
-        auto begin =
-            mlir::FileLineColLoc::get(builder.getContext(), fileId, posLineChar.line + 1, posLineChar.character + 1);
+        auto &sourceLocations = getSourceLocations(sourceFile, fileName);
+        auto begin = getFileLineColLoc(sourceLocations, start);
         if (length <= 1)
         {
             return begin;
         }
 
-        auto endLineChar = parser.getLineAndCharacterOfPosition(sourceFile, start + length - 1);
-        auto end =
-            mlir::FileLineColLoc::get(builder.getContext(), fileId, endLineChar.line + 1, endLineChar.character + 1);
+        auto end = getFileLineColLoc(sourceLocations, start + length - 1);
         return mlir::FusedLoc::get(builder.getContext(), {begin, end});
     }
 
+    SourceLocations &getSourceLocations(ts::SourceFile sourceFile, StringRef fileName)
+    {
+        auto &sourceLocations = sourceLocationsMap[sourceFile.operator->()];
+        if (!sourceLocations.fileId || sourceLocations.fileId.getValue() != fileName)
+        {
+            sourceLocations.sourceFile = sourceFile;
+            sourceLocations.fileId = getStringAttr(fileName.str());
+            sourceLocations.lineStarts = &parser.getLineStarts(sourceFile);
+            sourceLocations.line = 0;
+            sourceLocations.locations.clear();
+        }
+
+        return sourceLocations;
+    }
+
+    mlir::FileLineColLoc getFileLineColLoc(SourceLocations &sourceLocations, int pos)
+    {
+        auto &location = sourceLocations.locations[pos];
+        if (location)
+        {
+            return location;
+        }
+
+        // nodes are visited mostly in order of the text, so the line of the previous position is checked first
+        auto &lineStarts = *sourceLocations.lineStarts;
+        auto line = sourceLocations.line;
+        auto isOnLine = [&](size_t line) {
+            return line < lineStarts.size() && lineStarts[line] <= pos && (line + 1 == lineStarts.size() || pos < lineStarts[line + 1]);
+        };
+
+        if (!isOnLine(line) && !isOnLine(++line))
+        {
+            line = std::max<size_t>(std::upper_bound(lineStarts.begin(), lineStarts.end(), pos) - lineStarts.begin(), 1) - 1;
+        }
+
+        sourceLocations.line = line;
+        location = mlir::FileLineColLoc::get(sourceLocations.fileId, line + 1, pos - lineStarts[line] + 1);
+        return location;
+    }
+
     size_t getPos(mlir::FileLineColLoc location)
     {
         return location.getLine() + location.getColumn();
@@ -15555,6 +15813,7 @@ genContext);
     {
         Parser parser;
         auto module = parser.parseSourceFile(S("Temp"), src, ScriptTarget::Latest);
+        loadedSourceFiles.push_back(module);
 
         MLIRNamespaceGuard nsGuard(currentNamespace);
         currentNamespace = rootNamespace;
@@ -15598,9 +15857,16 @@ genContext);
             return {SourceFile(), std::vector<SourceFile>()};
         }
 
+        dependencies.push_back(fullPath.str().str());
+        // import is processed on each run of code generation
+        if (!llvm::is_contained(importedModules, fullPath.str()))
+        {
+            importedModules.push_back(fullPath.str().str());
+        }
+
         auto moduleSource = fileOrErr.get()->getBuffer();
 
-        return loadSourceFile(fileName, moduleSource.str());
+        return loadSourceFile(fileName, moduleSource);
     }
 
     /// The builder is a helper class to create IR inside a function. The builder
@@ -15646,21 +15912,39 @@ genContext);
     Parser parser;
     ts::SourceFile sourceFile;
 
+    // nodes of parsed files are freed with the files, declarations refer to them till the end of code generation
+    std::vector<ts::SourceFile> loadedSourceFiles;
+
+    llvm::DenseMap<const void *, SourceLocations> sourceLocationsMap;
+
     std::string label;
 
     bool declarationMode;
+
+    std::vector<std::string> dependencies;
+
+    std::vector<std::string> importedModules;
 };
 } // namespace
 
 namespace typescript
 {
+::std::shared_ptr<IncludeFilesCache> createIncludeFilesCache()
+{
+    return ::std::make_shared<IncludeFilesCache>();
+}
+
 ::std::string dumpFromSource(const llvm::StringRef &fileName, const llvm::StringRef &source)
 {
     auto showLineCharPos = false;
 
+    // nodes created while the tree is dumped are freed with it
+    auto nodeArena = std::make_shared<NodeArena>();
+    NodeArenaScope nodeArenaScope(nodeArena.get());
+
     Parser parser;
     auto sourceFile = parser.parseSourceFile(stows(static_cast<std::string>(fileName)),
-                                             stows(static_cast<std::string>(source)), ScriptTarget::Latest);
+                                             stows(source.data(), source.size()), ScriptTarget::Latest);
 
     stringstream s;
 
@@ -15711,13 +15995,35 @@ namespace typescript
 }
 
 mlir::OwningOpRef<mlir::ModuleOp> mlirGenFromSource(const mlir::MLIRContext &context, const llvm::StringRef &fileName,
-                                        const llvm::StringRef &source, CompileOptions compileOptions)
+                                        const llvm::StringRef &source, CompileOptions compileOptions,
+                                        std::vector<std::string> *dependencies, std::vector<std::string> *importedModules,
+                                        mlir::TimingScope *timingScope)
 {
+    mlir::TimingScope noTiming;
+    auto &timing = timingScope ? *timingScope : noTiming;
+
+    // nodes created by the code generator are freed after the compilation, they are never attached to the trees of
+    // cached include files (see IncludeFilesCache), which have arenas of their own
+    auto nodeArena = std::make_shared<NodeArena>();
+    NodeArenaScope nodeArenaScope(nodeArena.get());
 
     SmallString<128> path = llvm::sys::path::parent_path(fileName);
     MLIRGenImpl mlirGenImpl(context, fileName, path, compileOptions);
+    auto parsingTiming = timing.nest("Parsing");
     auto [sourceFile, includeFiles] = mlirGenImpl.loadSourceFile(fileName, source);
-    return mlirGenImpl.mlirGenSourceFile(sourceFile, includeFiles);
+    parsingTiming.stop();
+    auto module = mlirGenImpl.mlirGenSourceFile(sourceFile, includeFiles, timing);
+    if (dependencies)
+    {
+        *dependencies = mlirGenImpl.getDependencies();
+    }
+
+    if (importedModules)
+    {
+        *importedModules = mlirGenImpl.getImportedModules();
+    }
+
+    return module;
 }
 
 } // namespace typescript
@@ -0,0 +1,216 @@
+// Profile runtime of JIT runs with --profile-generate. The raw profile is written by compiler-rt (clang_rt.profile,
+// linked into this library), the same runtime executables built with --profile-generate are linked with, so the format
+// always matches llvm-profdata of the same LLVM.
+//
+// compiler-rt finds the profile sections by the platform hooks (__llvm_profile_begin_data etc., see
+// InstrProfilingPlatform*.c), for executables they return the sections merged by the linker. JIT-ed code is not
+// linked, so this file implements the hooks instead of compiler-rt's ones: the JIT memory manager places the profile
+// sections of loaded objects into the ranges below (__tsc_profile_allocate_section), and the hooks return these ranges.
+
+#include "llvm/ADT/StringMap.h"
+
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+
+// defines the version of the raw profile compiler-rt writes
+#include "llvm/ProfileData/InstrProfData.inc"
+
+extern "C"
+{
+    // types of compiler-rt, used by pointer only
+    struct __llvm_profile_data;
+    struct ValueProfNode;
+    struct ProfDataWriter;
+
+    // compiler-rt API
+    int __llvm_profile_write_file(void);
+    void __llvm_profile_instrument_target(uint64_t targetValue, void *data, uint32_t counterIndex);
+    void __llvm_profile_instrument_memop(uint64_t targetValue, void *data, uint32_t counterIndex);
+    extern int __llvm_profile_runtime;
+
+    // read by compiler-rt as the version of the instrumented code (compiler-rt has weak definition of it), set from
+    // the JIT-ed modules before the profile is written
+    uint64_t __llvm_profile_raw_version = INSTR_PROF_RAW_VERSION | VARIANT_MASK_IR_PROF;
+
+    // value profiling allocates nodes from this range, see InstrProfilingValue.c
+    ValueProfNode *CurrentVNode = nullptr;
+    ValueProfNode *EndVNode = nullptr;
+}
+
+namespace
+{
+
+// the same order as kinds of __tsc_profile_allocate_section
+enum ProfileSectionKind
+{
+    ProfileData,
+    ProfileCounters,
+    ProfileNames,
+    ProfileValueNodes,
+    ProfileSectionKindCount
+};
+
+// sections are laid out one after another as the linker merges them, memory is reserved at once because records refer
+// to counters by relative offsets and the ranges must not move; calloc of large blocks only reserves pages
+const size_t profileSectionCapacity[ProfileSectionKindCount] = {64 << 20, 64 << 20, 16 << 20, 16 << 20};
+
+struct ProfileSection
+{
+    char *begin = nullptr;
+    char *end = nullptr;
+};
+
+std::mutex profileMutex;
+ProfileSection profileSections[ProfileSectionKindCount];
+
+ProfileSection &getProfileSection(int kind)
+{
+    auto &section = profileSections[kind];
+    if (!section.begin)
+    {
+        section.begin = section.end = static_cast<char *>(calloc(profileSectionCapacity[kind], 1));
+        if (section.begin && kind == ProfileValueNodes)
+        {
+            // the whole range is a pool of nodes, like the static nodes section compiler-rt allocates from
+            CurrentVNode = reinterpret_cast<ValueProfNode *>(section.begin);
+            EndVNode = reinterpret_cast<ValueProfNode *>(section.begin + profileSectionCapacity[kind]);
+        }
+    }
+
+    return section;
+}
+
+ProfileSection getProfileSectionRange(int kind)
+{
+    std::lock_guard<std::mutex> lock(profileMutex);
+    return getProfileSection(kind);
+}
+
+} // namespace
+
+namespace mlir
+{
+namespace runtime
+{
+
+// memory for a profile section of JIT-ed object, kind is ProfileSectionKind, nullptr if there is no room
+extern "C" void *__tsc_profile_allocate_section(int kind, uint64_t size, uint32_t alignment)
+{
+    if (kind < 0 || kind >= ProfileSectionKindCount)
+    {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(profileMutex);
+
+    // the pool of value nodes is needed before the instrumented code runs, even if its objects have no nodes section
+    getProfileSection(ProfileValueNodes);
+
+    auto &section = getProfileSection(kind);
+    if (!section.begin)
+    {
+        return nullptr;
+    }
+
+    auto align = alignment ? alignment : 1;
+    auto offset = (static_cast<uint64_t>(section.end - section.begin) + align - 1) / align * align;
+    if (offset + size > profileSectionCapacity[kind])
+    {
+        return nullptr;
+    }
+
+    section.end = section.begin + offset + size;
+    return section.begin + offset;
+}
+
+// writes the profile to LLVM_PROFILE_FILE (default.profraw by default), version is the value of
+// __llvm_profile_raw_version of the instrumented code
+extern "C" int __tsc_profile_write(uint64_t version)
+{
+    __llvm_profile_raw_version = version;
+    return __llvm_profile_write_file();
+}
+
+} // namespace runtime
+} // namespace mlir
+
+//===----------------------------------------------------------------------===//
+// compiler-rt platform hooks
+//===----------------------------------------------------------------------===//
+
+extern "C"
+{
+    const __llvm_profile_data *__llvm_profile_begin_data(void)
+    {
+        return reinterpret_cast<const __llvm_profile_data *>(getProfileSectionRange(ProfileData).begin);
+    }
+
+    const __llvm_profile_data *__llvm_profile_end_data(void)
+    {
+        return reinterpret_cast<const __llvm_profile_data *>(getProfileSectionRange(ProfileData).end);
+    }
+
+    char *__llvm_profile_begin_counters(void)
+    {
+        return getProfileSectionRange(ProfileCounters).begin;
+    }
+
+    char *__llvm_profile_end_counters(void)
+    {
+        return getProfileSectionRange(ProfileCounters).end;
+    }
+
+    const char *__llvm_profile_begin_names(void)
+    {
+        return getProfileSectionRange(ProfileNames).begin;
+    }
+
+    const char *__llvm_profile_end_names(void)
+    {
+        return getProfileSectionRange(ProfileNames).end;
+    }
+
+    ValueProfNode *__llvm_profile_begin_vnodes(void)
+    {
+        return reinterpret_cast<ValueProfNode *>(getProfileSectionRange(ProfileValueNodes).begin);
+    }
+
+    ValueProfNode *__llvm_profile_end_vnodes(void)
+    {
+        return EndVNode;
+    }
+
+    uint32_t *__llvm_profile_begin_orderfile(void)
+    {
+        return nullptr;
+    }
+
+    // JIT-ed code has no build id
+    int __llvm_write_binary_ids(ProfDataWriter *)
+    {
+        return 0;
+    }
+}
+
+//===----------------------------------------------------------------------===//
+// MLIR Runner (JitRunner) dynamic library integration.
+//===----------------------------------------------------------------------===//
+
+// NOLINTNEXTLINE(*-identifier-naming): externally called.
+void init_profileruntime(llvm::StringMap<void *> &exportSymbols)
+{
+    auto exportSymbol = [&](llvm::StringRef name, auto ptr) {
+        assert(exportSymbols.count(name) == 0 && "symbol already exists");
+        exportSymbols[name] = reinterpret_cast<void *>(ptr);
+    };
+
+    exportSymbol("__tsc_profile_allocate_section", &mlir::runtime::__tsc_profile_allocate_section);
+    exportSymbol("__tsc_profile_write", &mlir::runtime::__tsc_profile_write);
+
+    // referenced by the instrumented code
+    exportSymbol("__llvm_profile_instrument_target", &__llvm_profile_instrument_target);
+    exportSymbol("__llvm_profile_instrument_memop", &__llvm_profile_instrument_memop);
+    exportSymbol("__llvm_profile_runtime", &__llvm_profile_runtime);
+}
@@ -15,6 +15,10 @@ void init_memruntime(llvm::StringMap<void *> &exportSymbols);
 void init_asyncruntime(llvm::StringMap<void *> &exportSymbols);
 void destroy_asyncruntime();
 
+#ifdef TSC_PROFILE_RUNTIME
+void init_profileruntime(llvm::StringMap<void *> &exportSymbols);
+#endif
+
 // Export symbols for the MLIR runner integration. All other symbols are hidden.
 #ifdef _WIN32
 #define API __declspec(dllexport)
@@ -30,6 +34,9 @@ void __mlir_runner_init(llvm::StringMap<void *> &exportSymbols)
     init_gcruntime(exportSymbols);
     init_memruntime(exportSymbols);
     init_asyncruntime(exportSymbols);
+#ifdef TSC_PROFILE_RUNTIME
+    init_profileruntime(exportSymbols);
+#endif
 }
 
 extern "C" API void __mlir_runner_destroy()
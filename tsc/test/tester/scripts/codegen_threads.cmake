@@ -0,0 +1,12 @@
+# --codegen-threads: the module is split into partitions which are optimized and emitted on their own threads, the
+# executable prints the same as the one built on one thread
+include("${CMAKE_CURRENT_LIST_DIR}/common.cmake")
+
+foreach (test ${TEST})
+    get_filename_component(name "${test}" NAME_WE)
+    build_and_run(output_single "${name}-single" --opt "${test}")
+    check_done("${output_single}")
+
+    build_and_run(output_threads "${name}-threads" --opt --codegen-threads=4 "${test}")
+    check_same_output("${output_single}" "${output_threads}" "output of ${name} built with --codegen-threads=4 is different")
+endforeach()
@@ -0,0 +1,58 @@
+# Helpers of the tests which run tsc several times and compare the results of the runs (cmake -P <test>.cmake).
+#
+# Variables given by add_test:
+#   TSC         - tsc executable
+#   TSC_RUNTIME - TypeScriptRuntime shared library (JIT runs)
+#   WORK_DIR    - folder of the files of the test, it is created empty
+#   TEST        - .ts file(s) of the test
+
+cmake_minimum_required(VERSION 3.17.3)
+
+# runs the command in WORK_DIR, the test fails when the command fails or reports anything to stderr, stdout is
+# returned in the variable
+function(run_checked output)
+    execute_process(COMMAND ${ARGN} WORKING_DIRECTORY "${WORK_DIR}" RESULT_VARIABLE result OUTPUT_VARIABLE out ERROR_VARIABLE err)
+    if (NOT "${result}" STREQUAL "0" OR NOT "${err}" STREQUAL "")
+        string(REPLACE ";" " " command "${ARGN}")
+        message(FATAL_ERROR "${command}\nexit code: ${result}\n${out}${err}")
+    endif()
+
+    set(${output} "${out}" PARENT_SCOPE)
+endfunction()
+
+# runs the command in WORK_DIR, exit code and stdout are returned in the variables, stderr is ignored
+function(run_with_result result output)
+    execute_process(COMMAND ${ARGN} WORKING_DIRECTORY "${WORK_DIR}" RESULT_VARIABLE code OUTPUT_VARIABLE out ERROR_VARIABLE err)
+    set(${result} "${code}" PARENT_SCOPE)
+    set(${output} "${out}" PARENT_SCOPE)
+endfunction()
+
+# compiles the .ts file(s) and the options given after the name of the executable with -emit=exe, runs the executable
+# and returns its stdout, the test fails when the compilation or the run fails
+function(build_and_run output name)
+    if (CMAKE_HOST_WIN32)
+        set(exe "${WORK_DIR}/${name}.exe")
+    else()
+        set(exe "${WORK_DIR}/${name}")
+    endif()
+
+    run_checked(build_output "${TSC}" --emit=exe -nogc -o "${exe}" ${ARGN})
+    run_checked(out "${exe}")
+    set(${output} "${out}" PARENT_SCOPE)
+endfunction()
+
+# the tests print 'done.' when they are finished
+function(check_done output)
+    if (NOT "${output}" MATCHES "done\\.")
+        message(FATAL_ERROR "no 'done.' msg in output:\n${output}")
+    endif()
+endfunction()
+
+function(check_same_output first second description)
+    if (NOT "${first}" STREQUAL "${second}")
+        message(FATAL_ERROR "${description}:\n${first}\n---\n${second}")
+    endif()
+endfunction()
+
+file(REMOVE_RECURSE "${WORK_DIR}")
+file(MAKE_DIRECTORY "${WORK_DIR}")
@@ -0,0 +1,38 @@
+# --cache-dir with -emit=exe: the first build compiles the source and stores the object file, the second one takes it
+# from the cache (the source is not parsed), a changed source is compiled again, the executables of all builds print
+# what the source says
+include("${CMAKE_CURRENT_LIST_DIR}/common.cmake")
+
+get_filename_component(name "${TEST}" NAME)
+set(source "${WORK_DIR}/${name}")
+configure_file("${TEST}" "${source}" COPYONLY)
+
+function(build_with_cache output report run)
+    build_and_run(out "${run}" "--cache-dir=${WORK_DIR}/cache" --time-report=json "--time-report-file=${WORK_DIR}/${run}.json"
+                  "${source}")
+    file(READ "${WORK_DIR}/${run}.json" json)
+    set(${output} "${out}" PARENT_SCOPE)
+    set(${report} "${json}" PARENT_SCOPE)
+endfunction()
+
+build_with_cache(output_miss report_miss miss)
+check_done("${output_miss}")
+if (NOT report_miss MATCHES "\"Parsing\"")
+    message(FATAL_ERROR "the first build has not compiled the source:\n${report_miss}")
+endif()
+
+build_with_cache(output_hit report_hit hit)
+check_same_output("${output_miss}" "${output_hit}" "output of the executable built from the cache is different")
+if (report_hit MATCHES "\"Parsing\"")
+    message(FATAL_ERROR "the second build has not taken the object file from the cache:\n${report_hit}")
+endif()
+
+# the entry of the old source must not be used
+file(READ "${source}" text)
+string(REPLACE "done." "done. (changed)" text "${text}")
+file(WRITE "${source}" "${text}")
+
+build_with_cache(output_changed report_changed changed)
+if (NOT report_changed MATCHES "\"Parsing\"" OR NOT output_changed MATCHES "done\\. \\(changed\\)")
+    message(FATAL_ERROR "the changed source has not been compiled:\n${output_changed}\n${report_changed}")
+endif()
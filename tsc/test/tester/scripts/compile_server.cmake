@@ -0,0 +1,79 @@
+# --serve and --connect: a build sent to the compile server prints, creates and returns the same as the build run by
+# tsc itself, the source can be read from stdin of the client, an error is reported to stderr of the client with the
+# exit code of tsc
+include("${CMAKE_CURRENT_LIST_DIR}/common.cmake")
+
+# the path of a unix socket is limited to ~100 chars, the folder of the build can be longer
+string(RANDOM LENGTH 8 id)
+set(socket "/tmp/tsc-test-${id}.sock")
+
+execute_process(COMMAND sh -c "\"$0\" --serve \"--socket=$1\" --server-workers=2 > \"$2\" 2>&1 & echo $!" "${TSC}" "${socket}"
+                        "${WORK_DIR}/server.log"
+                OUTPUT_VARIABLE server_pid OUTPUT_STRIP_TRAILING_WHITESPACE)
+
+# SIGTERM stops the server with its workers
+function(stop_server)
+    execute_process(COMMAND kill "${server_pid}")
+endfunction()
+
+# the server is stopped before the test fails
+function(fail message)
+    stop_server()
+    file(READ "${WORK_DIR}/server.log" log)
+    message(FATAL_ERROR "${message}\nserver log:\n${log}")
+endfunction()
+
+foreach (attempt RANGE 300)
+    if (EXISTS "${socket}")
+        break()
+    endif()
+
+    execute_process(COMMAND "${CMAKE_COMMAND}" -E sleep 0.1)
+endforeach()
+
+if (NOT EXISTS "${socket}")
+    fail("the compile server has not started")
+endif()
+
+# runs tsc and the executable it builds (if any) in WORK_DIR, the source can be given on stdin
+function(build_and_run_exe result output error name)
+    cmake_parse_arguments(ARG "" "INPUT_FILE" "" ${ARGN})
+    if (ARG_INPUT_FILE)
+        set(input INPUT_FILE "${ARG_INPUT_FILE}")
+    endif()
+
+    execute_process(COMMAND "${TSC}" --emit=exe -nogc -o "${name}" ${ARG_UNPARSED_ARGUMENTS} ${input} WORKING_DIRECTORY "${WORK_DIR}"
+                    RESULT_VARIABLE code ERROR_VARIABLE err)
+    set(out "")
+    if ("${code}" STREQUAL "0")
+        execute_process(COMMAND "${WORK_DIR}/${name}" WORKING_DIRECTORY "${WORK_DIR}" OUTPUT_VARIABLE out)
+    endif()
+
+    set(${result} "${code}" PARENT_SCOPE)
+    set(${output} "${out}" PARENT_SCOPE)
+    set(${error} "${err}" PARENT_SCOPE)
+endfunction()
+
+build_and_run_exe(result_direct output_direct error_direct direct "${TEST}")
+if (NOT "${result_direct}" STREQUAL "0" OR NOT "${output_direct}" MATCHES "done\\.")
+    fail("tsc has not built the test (${result_direct}):\n${error_direct}${output_direct}")
+endif()
+
+build_and_run_exe(result_server output_server error_server server --connect "--socket=${socket}" "${TEST}")
+if (NOT "${result_server}" STREQUAL "0" OR NOT "${error_server}" STREQUAL "" OR NOT "${output_server}" STREQUAL "${output_direct}")
+    fail("the compile server has not built the test (${result_server}):\n${error_server}${output_server}")
+endif()
+
+build_and_run_exe(result_stdin output_stdin error_stdin stdin --connect "--socket=${socket}" INPUT_FILE "${TEST}")
+if (NOT "${result_stdin}" STREQUAL "0" OR NOT "${error_stdin}" STREQUAL "" OR NOT "${output_stdin}" STREQUAL "${output_direct}")
+    fail("the compile server has not built the test read from stdin (${result_stdin}):\n${error_stdin}${output_stdin}")
+endif()
+
+file(WRITE "${WORK_DIR}/error.ts" "function main() {\n    let a: number = ;\n}\n")
+build_and_run_exe(result_error output_error error_error error error.ts)
+build_and_run_exe(result_server_error output_server_error error_server_error server_error --connect "--socket=${socket}" error.ts)
+if ("${result_error}" STREQUAL "0" OR NOT "${result_server_error}" STREQUAL "${result_error}" OR "${error_server_error}" STREQUAL "")
+    fail("exit codes of the error: ${result_error} (tsc), ${result_server_error} (compile server):\n${error_server_error}")
+endif()
+
+stop_server()
@@ -0,0 +1,23 @@
+# --cache-dir with -emit=jit: the first run compiles the module and stores its object, the second one loads the object
+# (no LLVM pipeline in its time report), both print the same as the run without the cache
+include("${CMAKE_CURRENT_LIST_DIR}/common.cmake")
+
+set(jit_options --emit=jit --opt "--shared-libs=${TSC_RUNTIME}")
+
+run_checked(output_no_cache "${TSC}" ${jit_options} "${TEST}")
+check_done("${output_no_cache}")
+
+foreach (run miss hit)
+    run_checked(output_${run} "${TSC}" ${jit_options} "--cache-dir=${WORK_DIR}/cache" --time-report=json
+                "--time-report-file=${WORK_DIR}/${run}.json" "${TEST}")
+    check_same_output("${output_no_cache}" "${output_${run}}" "output of JIT run with cache (${run}) is different")
+    file(READ "${WORK_DIR}/${run}.json" report_${run})
+endforeach()
+
+if (NOT report_miss MATCHES "\"LLVM Pipeline\"")
+    message(FATAL_ERROR "the first run has not compiled the module:\n${report_miss}")
+endif()
+
+if (report_hit MATCHES "\"LLVM Pipeline\"")
+    message(FATAL_ERROR "the second run has not taken the object from the cache:\n${report_hit}")
+endif()
@@ -0,0 +1,47 @@
+# --profile-generate and --profile-use with -emit=exe and -emit=jit: the instrumented program writes the raw profile,
+# llvm-profdata reads it and merges it, the program built with the merged profile prints the same (a profile which
+# doesn't match the program is reported to stderr)
+#
+# Variables given by add_test in addition to the ones of common.cmake:
+#   PROFILE_LIB_DIR - folder of clang_rt.profile of compiler-rt
+#   LLVM_PROFDATA   - llvm-profdata executable
+include("${CMAKE_CURRENT_LIST_DIR}/common.cmake")
+
+# the profile has the counters of the functions which have run
+function(check_profile kind)
+    if (NOT EXISTS "${WORK_DIR}/${kind}.profraw")
+        message(FATAL_ERROR "${kind}: the instrumented program has not written ${kind}.profraw")
+    endif()
+
+    run_checked(show "${LLVM_PROFDATA}" show "${WORK_DIR}/${kind}.profraw")
+    if (NOT show MATCHES "Total functions: [1-9]" OR NOT show MATCHES "Maximum function count: [1-9]")
+        message(FATAL_ERROR "${kind}: no counters in the profile:\n${show}")
+    endif()
+
+    run_checked(merge "${LLVM_PROFDATA}" merge -o "${WORK_DIR}/${kind}.profdata" "${WORK_DIR}/${kind}.profraw")
+endfunction()
+
+# -emit=exe
+if (CMAKE_HOST_WIN32)
+    set(exe "${WORK_DIR}/instrumented.exe")
+else()
+    set(exe "${WORK_DIR}/instrumented")
+endif()
+
+run_checked(build_output "${TSC}" --emit=exe --opt -nogc "-L${PROFILE_LIB_DIR}" --profile-generate -o "${exe}" "${TEST}")
+run_checked(output_instrumented "${CMAKE_COMMAND}" -E env "LLVM_PROFILE_FILE=${WORK_DIR}/exe.profraw" "${exe}")
+check_done("${output_instrumented}")
+check_profile(exe)
+
+build_and_run(output_optimized optimized --opt "--profile-use=${WORK_DIR}/exe.profdata" "${TEST}")
+check_same_output("${output_instrumented}" "${output_optimized}" "output of the executable built with the profile is different")
+
+# -emit=jit, the profile is written by the profile runtime of TypeScriptRuntime
+set(jit_options --emit=jit --opt "--shared-libs=${TSC_RUNTIME}")
+run_checked(output_jit_instrumented "${CMAKE_COMMAND}" -E env "LLVM_PROFILE_FILE=${WORK_DIR}/jit.profraw" "${TSC}" ${jit_options}
+            --profile-generate "${TEST}")
+check_same_output("${output_instrumented}" "${output_jit_instrumented}" "output of the instrumented JIT run is different")
+check_profile(jit)
+
+run_checked(output_jit_optimized "${TSC}" ${jit_options} "--profile-use=${WORK_DIR}/jit.profdata" "${TEST}")
+check_same_output("${output_instrumented}" "${output_jit_optimized}" "output of the JIT run with the profile is different")
@@ -0,0 +1,57 @@
+# --time-report=json: the report is valid JSON, each node has the times, peak RSS and the count of its runs, the
+# phases of -emit=exe are the children of the root node (cmake 3.19+, string(JSON))
+include("${CMAKE_CURRENT_LIST_DIR}/common.cmake")
+
+build_and_run(output test --time-report=json "--time-report-file=${WORK_DIR}/report.json" "${TEST}")
+check_done("${output}")
+file(READ "${WORK_DIR}/report.json" report)
+
+# checks the node at the path (member names and indexes of the JSON) and its children
+function(check_node path)
+    string(JSON name ERROR_VARIABLE error GET "${report}" ${path} name)
+    if (error)
+        message(FATAL_ERROR "time report: ${error}\n${report}")
+    endif()
+
+    foreach (field wall user system peakRSS peakRSSGrowth count)
+        string(JSON value ERROR_VARIABLE error GET "${report}" ${path} ${field})
+        if (error OR NOT value MATCHES "^-?[0-9]+(\\.[0-9]+)?([eE][-+]?[0-9]+)?$")
+            message(FATAL_ERROR "time report: no number '${field}' in '${name}' (${error})\n${report}")
+        endif()
+    endforeach()
+
+    string(JSON count GET "${report}" ${path} count)
+    if (count LESS 1)
+        message(FATAL_ERROR "time report: '${name}' has not run\n${report}")
+    endif()
+
+    string(JSON children ERROR_VARIABLE error LENGTH "${report}" ${path} children)
+    if (NOT error)
+        math(EXPR last "${children} - 1")
+        foreach (index RANGE ${last})
+            check_node("${path};children;${index}")
+        endforeach()
+    endif()
+endfunction()
+
+check_node("")
+
+string(JSON root GET "${report}" name)
+if (NOT root STREQUAL "Total")
+    message(FATAL_ERROR "time report: root node is '${root}'\n${report}")
+endif()
+
+set(phases)
+string(JSON children LENGTH "${report}" children)
+math(EXPR last "${children} - 1")
+foreach (index RANGE ${last})
+    string(JSON phase GET "${report}" children ${index} name)
+    list(APPEND phases "${phase}")
+endforeach()
+
+foreach (phase "Initialization" "Parsing" "Discover Dependencies" "Code Generation" "MLIR Pipeline" "Translation to LLVM IR"
+               "LLVM Pipeline" "Code Emission" "Linking")
+    if (NOT phase IN_LIST phases)
+        message(FATAL_ERROR "time report: no phase '${phase}' in ${phases}\n${report}")
+    endif()
+endforeach()
@@ -9,6 +9,7 @@
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 #ifdef WIN32
 #include <windows.h>
@@ -121,6 +122,7 @@ bool isJitCompile = false;
 bool enableBuiltins = false;
 bool noGC = false;
 bool asyncRuntime = false;
+bool isExe = false;
 
 bool hasEnding(std::string const &fullString, std::string const &ending)
 {
@@ -415,14 +417,22 @@ void createJitBatchFile()
     }
 #endif
 
+    // the file and tsc options follow the name of the test
     std::ofstream batFile("jit.bat");
     batFile << "echo off" << std::endl;
     batFile << "set FILENAME=%1" << std::endl;
     batFile << "set LLVMPATH=" << TEST_LLVM_EXEPATH << std::endl;
     batFile << "set TSCEXEPATH=" << TEST_TSC_EXEPATH << std::endl;
+    batFile << "set ARGS=" << std::endl;
+    batFile << ":args" << std::endl;
+    batFile << "shift" << std::endl;
+    batFile << "if \"%~1\"==\"\" goto run" << std::endl;
+    batFile << "set ARGS=%ARGS% %1" << std::endl;
+    batFile << "goto args" << std::endl;
+    batFile << ":run" << std::endl;
     batFile << "echo on" << std::endl;
     batFile
-        << "%TSCEXEPATH%\\tsc.exe --emit=jit -nogc --shared-libs=%LLVMPATH%/TypeScriptRuntime.dll %2 1> %FILENAME%.txt 2> %FILENAME%.err"
+        << "%TSCEXEPATH%\\tsc.exe --emit=jit -nogc --shared-libs=%LLVMPATH%/TypeScriptRuntime.dll %ARGS% 1> %FILENAME%.txt 2> %FILENAME%.err"
         << std::endl;
     batFile.close();
 }
@@ -436,15 +446,54 @@ void createJitBatchFileGC()
     }
 #endif
 
+    // the file and tsc options follow the name of the test
     std::ofstream batFile("jit_gc.bat");
     batFile << "echo off" << std::endl;
     batFile << "set FILENAME=%1" << std::endl;
     batFile << "set TSCEXEPATH=" << TEST_TSC_EXEPATH << std::endl;
+    batFile << "set ARGS=" << std::endl;
+    batFile << ":args" << std::endl;
+    batFile << "shift" << std::endl;
+    batFile << "if \"%~1\"==\"\" goto run" << std::endl;
+    batFile << "set ARGS=%ARGS% %1" << std::endl;
+    batFile << "goto args" << std::endl;
+    batFile << ":run" << std::endl;
     batFile << "echo on" << std::endl;
-    batFile << "%TSCEXEPATH%\\tsc.exe --emit=jit --shared-libs=%TSCEXEPATH%/TypeScriptRuntime.dll %2 1> %FILENAME%.txt 2> %FILENAME%.err"
+    batFile << "%TSCEXEPATH%\\tsc.exe --emit=jit --shared-libs=%TSCEXEPATH%/TypeScriptRuntime.dll %ARGS% 1> %FILENAME%.txt 2> %FILENAME%.err"
             << std::endl;
     batFile.close();
 }
+
+void createExeBatchFile()
+{
+#ifndef NEW_BAT
+    if (exists("compile_exe" _D_ ".bat"))
+    {
+        return;
+    }
+#endif
+
+    // all files (and tsc options) are compiled by one tsc call, executables are created in the folder %FILENAME%
+    std::ofstream batFile("compile_exe" _D_ ".bat");
+    batFile << "echo off" << std::endl;
+    batFile << "set FILENAME=%1" << std::endl;
+    batFile << "set TSCEXEPATH=" << TEST_TSC_EXEPATH << std::endl;
+    batFile << "set ARGS=" << std::endl;
+    batFile << ":args" << std::endl;
+    batFile << "shift" << std::endl;
+    batFile << "if \"%~1\"==\"\" goto compile" << std::endl;
+    batFile << "set ARGS=%ARGS% %1" << std::endl;
+    batFile << "goto args" << std::endl;
+    batFile << ":compile" << std::endl;
+    batFile << "mkdir %FILENAME%" << std::endl;
+    batFile << "cd %FILENAME%" << std::endl;
+    batFile << "%TSCEXEPATH%\\tsc.exe --emit=exe " _OPT_ "-nogc %ARGS% 2> ..\\%FILENAME%.err" << std::endl;
+    batFile << "for %%f in (*.exe) do call %%f 1>> ..\\%FILENAME%.txt 2>> ..\\%FILENAME%.err" << std::endl;
+    batFile << "cd .." << std::endl;
+    batFile << "rmdir /s /q %FILENAME%" << std::endl;
+    batFile << "echo on" << std::endl;
+    batFile.close();
+}
 #else
 void createCompileBatchFile()
 {
@@ -599,12 +648,14 @@ void createJitBatchFile()
     }
 #endif
 
+    // the file and tsc options follow the name of the test
     std::ofstream batFile("jit.sh");
     batFile << "FILENAME=$1" << std::endl;
+    batFile << "shift" << std::endl;
     batFile << "LLVMPATH=" << TEST_LLVM_EXEPATH << std::endl;
     batFile << "TSCEXEPATH=" << TEST_TSC_EXEPATH << std::endl;
     batFile << "$TSCEXEPATH/tsc --emit=jit " _OPT_
-               " -nogc --shared-libs=../../lib/libTypeScriptRuntime.so $2 1> $FILENAME.txt 2> $FILENAME.err"
+               " -nogc --shared-libs=../../lib/libTypeScriptRuntime.so \"$@\" 1> $FILENAME.txt 2> $FILENAME.err"
             << std::endl;
     batFile.close();
 }
@@ -618,18 +669,45 @@ void createJitBatchFileGC()
     }
 #endif
 
+    // the file and tsc options follow the name of the test
     std::ofstream batFile("jit_gc.sh");
     batFile << "FILENAME=$1" << std::endl;
+    batFile << "shift" << std::endl;
     batFile << "LLVMPATH=" << TEST_LLVM_EXEPATH << std::endl;
     batFile << "TSCEXEPATH=" << TEST_TSC_EXEPATH << std::endl;
-    batFile << "$TSCEXEPATH/tsc --emit=jit " _OPT_ " --shared-libs=../../lib/libTypeScriptRuntime.so $2 1> $FILENAME.txt 2> $FILENAME.err"
+    batFile << "$TSCEXEPATH/tsc --emit=jit " _OPT_ " --shared-libs=../../lib/libTypeScriptRuntime.so \"$@\" 1> $FILENAME.txt 2> $FILENAME.err"
             << std::endl;
     batFile.close();
 }
+
+void createExeBatchFile()
+{
+#ifndef NEW_BAT
+    if (exists("compile_exe.sh"))
+    {
+        return;
+    }
 #endif
 
-void testFile(const char *file)
+    // all files (and tsc options) are compiled by one tsc call, executables are created in the folder $FILENAME
+    std::ofstream batFile("compile_exe.sh");
+    batFile << "FILENAME=$1" << std::endl;
+    batFile << "shift" << std::endl;
+    batFile << "TSCEXEPATH=" << TEST_TSC_EXEPATH << std::endl;
+    batFile << "mkdir $FILENAME" << std::endl;
+    batFile << "cd $FILENAME" << std::endl;
+    batFile << "$TSCEXEPATH/tsc --emit=exe " _OPT_ "-nogc \"$@\" 2> ../$FILENAME.err" << std::endl;
+    batFile << "for EXEFILE in $(ls); do ./$EXEFILE 1>> ../$FILENAME.txt 2>> ../$FILENAME.err; done" << std::endl;
+    batFile << "cd .." << std::endl;
+    batFile << "rm -r $FILENAME" << std::endl;
+    batFile.close();
+}
+#endif
+
+void testFile(const std::vector<std::string> &files, const std::vector<std::string> &tscOptions)
 {
+    auto file = files.front().c_str();
+
     std::chrono::milliseconds ms =
         std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch());
 
@@ -663,12 +741,12 @@ void testFile(const char *file)
         std::ifstream infileO;
         infileO.open(txtFile, std::fstream::in);
         std::string lineO;
-        auto anyDoneMsg = false;
+        size_t doneMsgs = 0;
         while (std::getline(infileO, lineO))
         {
             if (lineO.find("done.") != std::string::npos)
             {
-                anyDoneMsg = true;
+                doneMsgs++;
             }
         }
 
@@ -696,7 +774,8 @@ void testFile(const char *file)
             return errStr;
         }
 
-        if (!anyDoneMsg)
+        // each executable of -exe prints its own 'done.'
+        if (doneMsgs < (isExe ? files.size() : 1))
         {
             return std::string("no 'done.' msg.");
         }
@@ -714,7 +793,20 @@ void testFile(const char *file)
 #define BAT_NAME ".sh "
 #endif
 
-    if (isJit)
+    if (isExe)
+    {
+        ss << RUN_CMD << "compile_exe" _D_ << BAT_NAME << stem.generic_string() << ms.count();
+        for (auto &tscOption : tscOptions)
+        {
+            ss << " " << tscOption;
+        }
+
+        for (auto &exeFile : files)
+        {
+            ss << " " << exeFile;
+        }
+    }
+    else if (isJit)
     {
         if (noGC)
         {
@@ -724,6 +816,11 @@ void testFile(const char *file)
         {
             ss << RUN_CMD << "jit_gc" << BAT_NAME << stem.generic_string() << ms.count() << " " << file;
         }
+
+        for (auto &tscOption : tscOptions)
+        {
+            ss << " " << tscOption;
+        }
     }
     else if (isJitCompile)
     {
@@ -793,7 +890,8 @@ int main(int argc, char **argv)
 {
     try
     {
-        char *filePath = nullptr;
+        std::vector<std::string> filePaths;
+        std::vector<std::string> tscOptions;
         auto index = 1;
         for (; index < argc; index++)
         {
@@ -818,13 +916,26 @@ int main(int argc, char **argv)
             {
                 asyncRuntime = true;
             }
+            else if (std::string(argv[index]) == "-exe")
+            {
+                isExe = true;
+            }
+            else if (std::string(argv[index]).rfind("--", 0) == 0)
+            {
+                // options of tsc, -exe and -jit only
+                tscOptions.push_back(argv[index]);
+            }
             else
             {
-                filePath = argv[index];
+                filePaths.push_back(argv[index]);
             }
         }
 
-        if (isJit)
+        if (isExe)
+        {
+            createExeBatchFile();
+        }
+        else if (isJit)
         {
             if (noGC)
             {
@@ -869,14 +980,12 @@ int main(int argc, char **argv)
             }
         }
 
-        if (index > 1)
+        if (filePaths.empty())
         {
-            testFile(filePath);
-        }
-        else
-        {
-            testFile(TEST_FILE);
+            filePaths.push_back(TEST_FILE);
         }
+
+        testFile(filePaths, tscOptions);
     }
     catch (const std::exception &e)
     {
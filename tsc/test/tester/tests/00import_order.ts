@@ -0,0 +1,10 @@
+import { nextInitOrder, depInitOrder } from "./00import_order_dep";
+
+// initializers of the imported module run before initializers of the importer
+let mainInitOrder = nextInitOrder();
+
+function main() {
+    assert(depInitOrder == 1, "imported module is initialized first");
+    assert(mainInitOrder == 2, "importer is initialized after imported module");
+    print("done.");
+}
@@ -0,0 +1,10 @@
+// imported by 00import_order.ts
+
+export let initCounter = 0;
+
+export function nextInitOrder() {
+    initCounter++;
+    return initCounter;
+}
+
+export let depInitOrder = nextInitOrder();
@@ -46,6 +46,58 @@ static auto wtoc(const wchar_t *in)
     return chars;
 }
 
+// decodes UTF-8 text into UTF-16 code units (as ctow does) in one pass, without intermediate copies of the text,
+// invalid sequences are decoded as U+FFFD
+inline std::wstring stows(const char *data, size_t length)
+{
+    std::wstring ws;
+    // there are never more code units than bytes
+    ws.reserve(length);
+
+    auto bytes = reinterpret_cast<const unsigned char *>(data);
+    auto end = bytes + length;
+    while (bytes < end)
+    {
+        auto byte = *bytes++;
+        if (byte < 0x80)
+        {
+            ws.push_back(static_cast<wchar_t>(byte));
+            continue;
+        }
+
+        auto trailing = byte >= 0xf0 ? 3 : byte >= 0xe0 ? 2 : byte >= 0xc0 ? 1 : 0;
+        auto codePoint = static_cast<unsigned int>(byte & (0x3f >> trailing));
+        auto valid = trailing > 0 && byte < 0xf5 && end - bytes >= trailing;
+        for (auto i = 0; valid && i < trailing; i++)
+        {
+            valid = (bytes[i] & 0xc0) == 0x80;
+            codePoint = (codePoint << 6) | (bytes[i] & 0x3f);
+        }
+
+        static const unsigned int minCodePoint[] = {0, 0x80, 0x800, 0x10000};
+        if (!valid || codePoint < minCodePoint[trailing] || codePoint > 0x10ffff ||
+            (codePoint >= 0xd800 && codePoint <= 0xdfff))
+        {
+            ws.push_back(static_cast<wchar_t>(0xfffd));
+            continue;
+        }
+
+        bytes += trailing;
+        if (codePoint >= 0x10000)
+        {
+            codePoint -= 0x10000;
+            ws.push_back(static_cast<wchar_t>(0xd800 + (codePoint >> 10)));
+            ws.push_back(static_cast<wchar_t>(0xdc00 + (codePoint & 0x3ff)));
+        }
+        else
+        {
+            ws.push_back(static_cast<wchar_t>(codePoint));
+        }
+    }
+
+    return ws;
+}
+
 static std::wstring stows(const std::string &s)
 {
     std::wstring ws(ctow(s.c_str()));
@@ -7,41 +7,13 @@ namespace ts
 {
 namespace IncrementalParser
 {
-struct IncrementalElement : Node
-{
-    Node parent;
-    boolean intersectsChange;
-    number length;
-    NodeArray<PTR(Node)> _children;
-};
-
-struct IncrementalNode : IncrementalElement
-{
-    boolean hasBeenIncrementallyParsed;
-
-    inline auto operator->()
-    {
-        return Node::operator->();
-    }
-
-    inline operator bool()
-    {
-        return Node::operator bool();
-    }
-};
-
-struct IncrementalNodeArray : NodeArray<IncrementalNode>, IncrementalElement
-{
-    number length;
-};
-
 // Allows finding nodes in the source file at a certain position in an efficient manner.
 // The implementation takes advantage of the calling pattern it knows the parser will
 // make in order to optimize finding nodes as quickly as possible.
 struct SyntaxCursor
 {
     SyntaxCursor(){};
-    SyntaxCursor(std::function<IncrementalNode(number)> currentNode) : currentNode{currentNode} {};
+    SyntaxCursor(std::function<Node(number)> currentNode) : currentNode{currentNode} {};
     SyntaxCursor(undefined_t){};
 
     inline operator bool()
@@ -49,11 +21,16 @@ struct SyntaxCursor
         return !!currentNode;
     }
 
-    std::function<IncrementalNode(number)> currentNode;
+    std::function<Node(number)> currentNode;
 };
 
 auto createSyntaxCursor(SourceFile sourceFile) -> SyntaxCursor;
+
+// Produces a new SourceFile for the 'newText' reusing the nodes of 'sourceFile' which are not affected by the change,
+// nodes of 'sourceFile' are moved to the new file (see Parser::updateSourceFile)
+auto updateSourceFile(Parser &parser, SourceFile sourceFile, string newText, TextChangeRange textChangeRange,
+                      boolean aggressiveChecks) -> SourceFile;
 } // namespace IncrementalParser
 } // namespace ts
 
-#endif // INCREMENTAL_PARSER_H
\ No newline at end of file
+#endif // INCREMENTAL_PARSER_H
@@ -0,0 +1,131 @@
+#ifndef NEW_PARSER_NODE_ARENA_H
+#define NEW_PARSER_NODE_ARENA_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * Bump allocator for nodes of the syntax tree.
+ *
+ * Nodes are not reference counted, all nodes created while parsing a file are allocated in the arena of the file
+ * and destroyed together with it (see data::SourceFile::nodeArena), nodes synthesized by the code generator are
+ * allocated in the arena of the compilation (see mlirGenFromSource). Nodes are created in the current arena of the
+ * thread which is set by NodeArenaScope, a node can't be created outside of any scope.
+ */
+class NodeArena
+{
+  public:
+    NodeArena() = default;
+
+    NodeArena(const NodeArena &) = delete;
+    NodeArena &operator=(const NodeArena &) = delete;
+
+    ~NodeArena()
+    {
+        // nodes refer to each other, destroy them in reverse order of creation
+        for (auto it = destructors.rbegin(); it != destructors.rend(); ++it)
+        {
+            it->destroy(it->object);
+        }
+    }
+
+    template <typename T, typename... Args> T *create(Args &&...args)
+    {
+        auto object = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        if constexpr (!std::is_trivially_destructible<T>::value)
+        {
+            destructors.push_back({object, [](void *object) { static_cast<T *>(object)->~T(); }});
+        }
+
+        return object;
+    }
+
+    /// keeps the arena (and the arenas it retains) alive as long as this one, used when nodes of the arena are
+    /// reused by the tree of this arena (see IncrementalParser::updateSourceFile)
+    void retain(std::shared_ptr<NodeArena> arena)
+    {
+        retained.insert(retained.end(), arena->retained.begin(), arena->retained.end());
+        retained.push_back(std::move(arena));
+    }
+
+    size_t retainedCount() const
+    {
+        return retained.size();
+    }
+
+    /// creates the node in the current arena of the thread, there is no arena for nodes created outside of any scope
+    /// as they would never be freed
+    template <typename T, typename... Args> static T *make(Args &&...args)
+    {
+        auto arena = currentRef();
+        assert(arena && "node is created outside of NodeArenaScope");
+        return arena->create<T>(std::forward<Args>(args)...);
+    }
+
+  private:
+    friend class NodeArenaScope;
+
+    struct Destructor
+    {
+        void *object;
+        void (*destroy)(void *);
+    };
+
+    static constexpr size_t BlockSize = 64 * 1024;
+
+    void *allocate(size_t size, size_t alignment)
+    {
+        auto offset = (blockOffset + alignment - 1) & ~(alignment - 1);
+        if (blocks.empty() || offset + size > blockSize)
+        {
+            // big nodes (hardly ever) get a block of their own
+            blockSize = size + alignment > BlockSize ? size + alignment : BlockSize;
+            blocks.emplace_back(new char[blockSize]);
+            offset = (alignment - reinterpret_cast<uintptr_t>(blocks.back().get()) % alignment) % alignment;
+        }
+
+        blockOffset = offset + size;
+        return blocks.back().get() + offset;
+    }
+
+    static NodeArena *&currentRef()
+    {
+        static thread_local NodeArena *currentArena = nullptr;
+        return currentArena;
+    }
+
+    std::vector<std::unique_ptr<char[]>> blocks;
+    size_t blockSize = 0;
+    size_t blockOffset = 0;
+    std::vector<Destructor> destructors;
+    std::vector<std::shared_ptr<NodeArena>> retained;
+};
+
+/// Makes the arena current for the thread while the scope is alive, scopes can be nested.
+class NodeArenaScope
+{
+  public:
+    NodeArenaScope(NodeArena *arena) : previous(NodeArena::currentRef())
+    {
+        NodeArena::currentRef() = arena;
+    }
+
+    ~NodeArenaScope()
+    {
+        NodeArena::currentRef() = previous;
+    }
+
+    NodeArenaScope(const NodeArenaScope &) = delete;
+    NodeArenaScope &operator=(const NodeArenaScope &) = delete;
+
+  private:
+    NodeArena *previous;
+};
+
+#endif // NEW_PARSER_NODE_ARENA_H
@@ -148,7 +148,8 @@ struct Parser
         scriptKind = ensureScriptKind(fileName, scriptKind);
         if (scriptKind == ScriptKind::JSON)
         {
-            auto result = parseJsonText(fileName, sourceText, languageVersion, syntaxCursor, setParentNodes);
+            auto result =
+                parseJsonText(fileName, std::move(sourceText), languageVersion, syntaxCursor, setParentNodes);
             // TODO: review if we need it
             // convertToObjectWorker(result, result.statements[0].expression, result.parseDiagnostics, /*returnValue*/
             // false,
@@ -162,7 +163,7 @@ struct Parser
             return result;
         }
 
-        initializeState(fileName, sourceText, languageVersion, syntaxCursor, scriptKind);
+        initializeState(fileName, std::move(sourceText), languageVersion, syntaxCursor, scriptKind);
 
         auto result = parseSourceFileWorker(languageVersion, setParentNodes, scriptKind);
 
@@ -201,7 +202,7 @@ struct Parser
                        IncrementalParser::SyntaxCursor syntaxCursor = undefined, boolean setParentNodes = false)
         -> JsonSourceFile
     {
-        initializeState(fileName, sourceText, languageVersion, syntaxCursor, ScriptKind::JSON);
+        initializeState(fileName, std::move(sourceText), languageVersion, syntaxCursor, ScriptKind::JSON);
         sourceFlags = contextFlags;
 
         // Prime the scanner.
@@ -307,7 +308,7 @@ struct Parser
                          IncrementalParser::SyntaxCursor _syntaxCursor, ScriptKind _scriptKind) -> void
     {
         fileName = normalizePath(_fileName);
-        sourceText = _sourceText;
+        sourceText = std::move(_sourceText);
         languageVersion = _languageVersion;
         syntaxCursor = _syntaxCursor;
         scriptKind = _scriptKind;
@@ -337,8 +338,8 @@ struct Parser
         }
         parseErrorBeforeNextFinishedNode = false;
 
-        // Initialize and prime the scanner before parsing the source elements.
-        scanner.setText(sourceText);
+        // Initialize and prime the scanner before parsing the source elements, the scanner does not copy the text
+        scanner.setText(safe_string(sourceText));
         scanner.setOnError(std::bind(&Parser::scanError, this, std::placeholders::_1, std::placeholders::_2));
         scanner.setScriptTarget(languageVersion);
         scanner.setLanguageVariant(languageVariant);
@@ -396,7 +397,7 @@ struct Parser
 
         // A member of ReadonlyArray<T> isn't assignable to a member of T[] (and prevents a direct cast) - but this is
         // where we set up those members so they can be in the future
-        processCommentPragmas(sourceFile, sourceText);
+        processCommentPragmas(sourceFile, sourceFile->text);
 
         auto reportPragmaDiagnostic = [&](pos_type pos, number end, DiagnosticMessage diagnostic) -> void {
             parseDiagnostics.push_back(createDetachedDiagnostic(fileName, pos, end, diagnostic));
@@ -478,7 +479,7 @@ struct Parser
             auto node = baseSyntaxCursor.currentNode(position);
             if (topLevel && node && containsPossibleTopLevelAwait(node))
             {
-                node.intersectsChange = true;
+                node->intersectsChange = true;
             }
             return node;
         };
@@ -601,7 +602,9 @@ struct Parser
             sourceFile = reparseTopLevelAwait(sourceFile);
         }
 
-        sourceFile->text = sourceText;
+        // parsing is done, the file takes the text (it is not copied)
+        sourceFile->text = std::move(sourceText);
+        scanner.setText(safe_string(sourceFile->text), 0, sourceFile->text.size());
         sourceFile->bindDiagnostics.clear();
         sourceFile->bindSuggestionDiagnostics.clear();
         sourceFile->languageVersion = languageVersion;
@@ -645,7 +648,7 @@ struct Parser
         setContextFlag(val, NodeFlags::AwaitContext);
     }
 
-    template <typename T> auto doOutsideOfContext(NodeFlags context, std::function<T()> func) -> T
+    template <typename T, typename F> auto doOutsideOfContext(NodeFlags context, F &&func) -> T
     {
         // contextFlagsToClear will contain only the context flags that are
         // currently set that we need to temporarily clear
@@ -668,7 +671,7 @@ struct Parser
         return func();
     }
 
-    template <typename T> auto doInsideOfContext(NodeFlags context, std::function<T()> func) -> T
+    template <typename T, typename F> auto doInsideOfContext(NodeFlags context, F &&func) -> T
     {
         // contextFlagsToSet will contain only the context flags that
         // are not currently set that we need to temporarily enable.
@@ -691,44 +694,44 @@ struct Parser
         return func();
     }
 
-    template <typename T> auto allowInAnd(std::function<T()> func) -> T
+    template <typename T, typename F> auto allowInAnd(F &&func) -> T
     {
-        return doOutsideOfContext(NodeFlags::DisallowInContext, func);
+        return doOutsideOfContext<T>(NodeFlags::DisallowInContext, func);
     }
 
-    template <typename T> auto disallowInAnd(std::function<T()> func) -> T
+    template <typename T, typename F> auto disallowInAnd(F &&func) -> T
     {
-        return doInsideOfContext(NodeFlags::DisallowInContext, func);
+        return doInsideOfContext<T>(NodeFlags::DisallowInContext, func);
     }
 
-    template <typename T> auto doInYieldContext(std::function<T()> func) -> T
+    template <typename T, typename F> auto doInYieldContext(F &&func) -> T
     {
-        return doInsideOfContext(NodeFlags::YieldContext, func);
+        return doInsideOfContext<T>(NodeFlags::YieldContext, func);
     }
 
-    template <typename T> auto doInDecoratorContext(std::function<T()> func) -> T
+    template <typename T, typename F> auto doInDecoratorContext(F &&func) -> T
     {
-        return doInsideOfContext(NodeFlags::DecoratorContext, func);
+        return doInsideOfContext<T>(NodeFlags::DecoratorContext, func);
     }
 
-    template <typename T> auto doInAwaitContext(std::function<T()> func) -> T
+    template <typename T, typename F> auto doInAwaitContext(F &&func) -> T
     {
-        return doInsideOfContext(NodeFlags::AwaitContext, func);
+        return doInsideOfContext<T>(NodeFlags::AwaitContext, func);
     }
 
-    template <typename T> auto doOutsideOfAwaitContext(std::function<T()> func) -> T
+    template <typename T, typename F> auto doOutsideOfAwaitContext(F &&func) -> T
     {
-        return doOutsideOfContext(NodeFlags::AwaitContext, func);
+        return doOutsideOfContext<T>(NodeFlags::AwaitContext, func);
     }
 
-    template <typename T> auto doInYieldAndAwaitContext(std::function<T()> func) -> T
+    template <typename T, typename F> auto doInYieldAndAwaitContext(F &&func) -> T
     {
-        return doInsideOfContext(NodeFlags::YieldContext | NodeFlags::AwaitContext, func);
+        return doInsideOfContext<T>(NodeFlags::YieldContext | NodeFlags::AwaitContext, func);
     }
 
-    template <typename T> auto doOutsideOfYieldAndAwaitContext(std::function<T()> func) -> T
+    template <typename T, typename F> auto doOutsideOfYieldAndAwaitContext(F &&func) -> T
     {
-        return doOutsideOfContext(NodeFlags::YieldContext | NodeFlags::AwaitContext, func);
+        return doOutsideOfContext<T>(NodeFlags::YieldContext | NodeFlags::AwaitContext, func);
     }
 
     auto inContext(NodeFlags flags)
@@ -826,7 +829,7 @@ struct Parser
         return currentToken = scanner.scan();
     }
 
-    template <typename T> auto nextTokenAnd(std::function<T()> func) -> T
+    template <typename T, typename F> auto nextTokenAnd(F &&func) -> T
     {
         nextToken();
         return func();
@@ -889,7 +892,7 @@ struct Parser
         return currentToken = scanner.scanJsxAttributeValue();
     }
 
-    template <typename T> auto speculationHelper(std::function<T()> callback, SpeculationKind speculationKind) -> T
+    template <typename T, typename F> auto speculationHelper(F &&callback, SpeculationKind speculationKind) -> T
     {
         // Keep track of the state we'll need to rollback to if lookahead fails (or if the
         // caller asked us to always reset our state).
@@ -931,7 +934,7 @@ struct Parser
      * was in immediately prior to invoking the callback.  The result of invoking the callback
      * is returned from this function.
      */
-    template <typename T> auto lookAhead(std::function<T()> callback) -> T
+    template <typename T, typename F> auto lookAhead(F &&callback) -> T
     {
         return speculationHelper<T>(callback, SpeculationKind::Lookahead);
     }
@@ -941,7 +944,7 @@ struct Parser
      * callback returns something truthy, then the parser state is not rolled back.  The result
      * of invoking the callback is returned from this function.
      */
-    template <typename T> auto tryParse(std::function<T()> callback) -> T
+    template <typename T, typename F> auto tryParse(F &&callback) -> T
     {
         return speculationHelper<T>(callback, SpeculationKind::TryParse);
     }
@@ -1109,8 +1112,9 @@ struct Parser
         -> NodeArray<Node>
     {
         auto array = factory.createNodeArray(elements, hasTrailingComma);
-        setTextRangePosEnd(array, pos, end != -1 ? end : scanner.getStartPos());
-        array->pos.textPos = pos.textPos;
+        // arrays are values, setTextRangePosEnd would update a copy
+        array->pos = pos;
+        array->_end = end != -1 ? end : scanner.getStartPos();
         return array;
     }
 
@@ -1119,8 +1123,9 @@ struct Parser
         -> NodeArray<T>
     {
         auto array = factory.createNodeArray<T>(elements, hasTrailingComma);
-        setTextRangePosEnd(array, pos, end != -1 ? end : scanner.getStartPos());
-        array->pos.textPos = pos.textPos;
+        // arrays are values, setTextRangePosEnd would update a copy
+        array->pos = pos;
+        array->_end = end != -1 ? end : scanner.getStartPos();
         return array;
     }
 
@@ -1668,7 +1673,7 @@ struct Parser
     }
 
     // Parses a list of elements
-    template <typename T> auto parseList(ParsingContext kind, std::function<T()> parseElement) -> NodeArray<T>
+    template <typename T, typename F> auto parseList(ParsingContext kind, F &&parseElement) -> NodeArray<T>
     {
         auto saveParsingContext = parsingContext;
         parsingContext |= (ParsingContext)(1 << (number)kind);
@@ -1679,7 +1684,7 @@ struct Parser
         {
             if (isListElement(kind, /*inErrorRecovery*/ false))
             {
-                auto element = parseListElement(kind, parseElement);
+                auto element = parseListElement<T>(kind, parseElement);
                 list.push_back(element);
 
                 continue;
@@ -1695,7 +1700,7 @@ struct Parser
         return createNodeArray(list, listPos);
     }
 
-    template <typename T> auto parseListElement(ParsingContext parsingContext, std::function<T()> parseElement) -> T
+    template <typename T, typename F> auto parseListElement(ParsingContext parsingContext, F &&parseElement) -> T
     {
         auto node = currentNode(parsingContext);
         if (node)
@@ -1728,7 +1733,7 @@ struct Parser
         // Can't reuse a node that intersected the change range.
         // Can't reuse a node that contains a parse error.  This is necessary so that we
         // produce the same set of errors again.
-        if (nodeIsMissing(node) || node.intersectsChange || containsParseError(node))
+        if (nodeIsMissing(node) || node->intersectsChange || containsParseError(node))
         {
             return undefined;
         }
@@ -1757,7 +1762,7 @@ struct Parser
             return undefined;
         }
 
-        if (node.as<JSDocContainer>()->jsDocCache.size() > 0)
+        if (node.is<JSDocContainer>() && node.as<JSDocContainer>()->jsDocCache.size() > 0)
         {
             // jsDocCache may include tags from parent nodes, which might have been modified.
             node.as<JSDocContainer>()->jsDocCache.clear();
@@ -2095,8 +2100,8 @@ struct Parser
     }
 
     // Parses a comma-delimited list of elements
-    template <typename T>
-    auto parseDelimitedList(ParsingContext kind, std::function<T()> parseElement,
+    template <typename T, typename F>
+    auto parseDelimitedList(ParsingContext kind, F &&parseElement,
                             boolean considerSemicolonAsDelimiter = false) -> NodeArray<T>
     {
         auto saveParsingContext = parsingContext;
@@ -2193,13 +2198,13 @@ struct Parser
         return arr.isMissingList;
     }
 
-    template <typename T>
-    auto parseBracketedList(ParsingContext kind, std::function<T()> parseElement, SyntaxKind open, SyntaxKind close)
+    template <typename T, typename F>
+    auto parseBracketedList(ParsingContext kind, F &&parseElement, SyntaxKind open, SyntaxKind close)
         -> NodeArray<T>
     {
         if (parseExpected(open))
         {
-            auto result = parseDelimitedList(kind, parseElement);
+            auto result = parseDelimitedList<T>(kind, parseElement);
             parseExpected(close);
             return result;
         }
@@ -3559,9 +3564,9 @@ struct Parser
         return undefined;
     }
 
-    auto parseUnionOrIntersectionType(SyntaxKind operator_, std::function<TypeNode()> parseConstituentType,
-                                      std::function<UnionOrIntersectionTypeNode(NodeArray<TypeNode>)> createTypeNode)
-        -> TypeNode
+    template <typename ParseConstituentType, typename CreateTypeNode>
+    auto parseUnionOrIntersectionType(SyntaxKind operator_, ParseConstituentType &&parseConstituentType,
+                                      CreateTypeNode &&createTypeNode) -> TypeNode
     {
         auto pos = getNodePos();
         auto isUnionType = operator_ == SyntaxKind::BarToken;
@@ -3584,15 +3589,15 @@ struct Parser
     auto parseIntersectionTypeOrHigher() -> TypeNode
     {
         return parseUnionOrIntersectionType(
-            SyntaxKind::AmpersandToken, std::bind(&Parser::parseTypeOperatorOrHigher, this),
-            std::bind(&NodeFactory::createIntersectionTypeNode, factory, std::placeholders::_1));
+            SyntaxKind::AmpersandToken, [&]() { return parseTypeOperatorOrHigher(); },
+            [&](NodeArray<TypeNode> types) { return factory.createIntersectionTypeNode(types); });
     }
 
     auto parseUnionTypeOrHigher() -> TypeNode
     {
         return parseUnionOrIntersectionType(
-            SyntaxKind::BarToken, std::bind(&Parser::parseIntersectionTypeOrHigher, this),
-            std::bind(&NodeFactory::createUnionTypeNode, factory, std::placeholders::_1));
+            SyntaxKind::BarToken, [&]() { return parseIntersectionTypeOrHigher(); },
+            [&](NodeArray<TypeNode> types) { return factory.createUnionTypeNode(types); });
     }
 
     auto nextTokenIsNewKeyword() -> boolean
@@ -5803,7 +5808,7 @@ struct Parser
             break;
         }
 
-        NodeArray<Expression> argumentsArray;
+        NodeArray<Expression> argumentsArray = undefined;
         if (token() == SyntaxKind::OpenParenToken)
         {
             argumentsArray = parseArgumentList();
@@ -6721,10 +6726,10 @@ struct Parser
 
             declarations = parseDelimitedList<VariableDeclaration>(
                 ParsingContext::VariableDeclarations,
-                inForStatementInitializer
-                    ? (std::function<VariableDeclaration()>)std::bind(&Parser::parseVariableDeclaration0, this)
-                    : (std::function<VariableDeclaration()>)std::bind(&Parser::parseVariableDeclarationAllowExclamation,
-                                                                      this));
+                [&]() {
+                    return inForStatementInitializer ? parseVariableDeclaration0()
+                                                     : parseVariableDeclarationAllowExclamation();
+                });
 
             setDisallowInContext(savedDisallowIn);
         }
@@ -7054,7 +7059,7 @@ struct Parser
 
     auto parseModifiersForArrowFunction() -> NodeArray<Modifier>
     {
-        NodeArray<Modifier> modifiers;
+        NodeArray<Modifier> modifiers = undefined;
         if (token() == SyntaxKind::AsyncKeyword)
         {
             auto pos = getNodePos();
@@ -7917,14 +7922,13 @@ struct Parser
         string _args;
     };
 
-    auto processCommentPragmas(SourceFile context, string sourceText) -> void
+    auto processCommentPragmas(SourceFile context, string &sourceText) -> void
     {
         std::vector<ts::data::PragmaPseudoMapEntry> pragmas;
 
         for (auto &range : scanner.getLeadingCommentRanges(sourceText, 0))
         {
-            auto comment = safe_string(sourceText).substring(range->pos, range->_end);
-            extractPragmas(pragmas, range, comment);
+            extractPragmas(pragmas, range, safe_string(sourceText.data() + range->pos, range->_end - range->pos));
         }
 
         context->pragmas.clear();
@@ -7948,13 +7952,14 @@ struct Parser
             auto key = pair.first;
             auto entryOrList = pair.second;
 
-            static std::map<string, int> cases = {
+            static const std::map<string, int> cases = {
                 {S("reference"), 1},  {S("amd-dependency"), 2},  {S("amd-module"), 3},
                 {S("ts-nocheck"), 4}, {S("ts-check"), 5},        {S("jsx"), 6},
                 {S("jsxfrag"), 7},    {S("jsximportsource"), 8}, {S("jsxruntime"), 9}};
 
             /*JSDocTag*/ Node tag;
-            auto index = cases[key];
+            auto found = cases.find(key);
+            auto index = found != cases.end() ? found->second : 0;
             switch (index)
             {
             case 1: {
@@ -8011,78 +8016,144 @@ struct Parser
     //     result;
     // }
 
-    regex tripleSlashXMLCommentStartRegEx = regex(S(R"(^///\s*<(\S+)\s(.*)?/>)"), std::regex_constants::ECMAScript);
-    regex singleLinePragmaRegEx = regex(S(R"(^///?\s*@(\S+)\s*(.*)\s*$)"), std::regex_constants::ECMAScript);
-    regex multiLinePragmaRegEx =
-        regex(S(R"(\s*@(\S+)\s*(.*)\s*$)"),
-              std::regex_constants::ECMAScript); // Defined inline since it uses the "g" flag,
-                                                 // which keeps a persistent index (for iterating)
+    /**
+     * Matches ^///\s*<(\S+)\s(.*)?/> and returns the tag name.
+     */
+    auto matchTripleSlashXMLCommentStart(safe_string text, string &name) -> boolean
+    {
+        if (text[0] != CharacterCodes::slash || text[1] != CharacterCodes::slash || text[2] != CharacterCodes::slash)
+        {
+            return false;
+        }
+
+        auto pos = 3;
+        while (scanner.isAsciiWhiteSpace(text[pos]))
+        {
+            pos++;
+        }
+
+        if (text[pos] != CharacterCodes::lessThan)
+        {
+            return false;
+        }
+
+        auto nameStart = ++pos;
+        while (pos < text.length() && !scanner.isAsciiWhiteSpace(text[pos]))
+        {
+            pos++;
+        }
+
+        if (pos == nameStart || pos == text.length())
+        {
+            return false;
+        }
+
+        name = text.substring(nameStart, pos);
+
+        // the tag is closed on the same line
+        for (pos++; pos < text.length() && !scanner.isLineBreak(text[pos]); pos++)
+        {
+            if (text[pos] == CharacterCodes::slash && text[pos + 1] == CharacterCodes::greaterThan)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
 
-    std::map<string, regex> namedArgRegExCache;
-    auto getNamedArgRegEx(string name) -> regex
+    struct NamedArgMatch
     {
-        if (namedArgRegExCache.count(name))
+        // position of the match and the length of the part before the quoted value
+        number index;
+        number prefixLength;
+        string value;
+    };
+
+    /**
+     * Finds the first match of (\s{name}\s*=\s*)('|")(.+?)\2.
+     */
+    auto matchNamedArg(safe_string text, const string &name, NamedArgMatch &match) -> boolean
+    {
+        auto nameLength = (number)name.size();
+        for (auto index = 0; index < text.length(); index++)
         {
-            return namedArgRegExCache.at(name);
+            if (!scanner.isAsciiWhiteSpace(text[index]) || text.length() - index - 1 < nameLength ||
+                std::char_traits<char_t>::compare(text.begin() + index + 1, name.data(), nameLength) != 0)
+            {
+                continue;
+            }
+
+            auto pos = index + 1 + nameLength;
+            while (scanner.isAsciiWhiteSpace(text[pos]))
+            {
+                pos++;
+            }
+
+            if (text[pos] != CharacterCodes::equals)
+            {
+                continue;
+            }
+
+            pos++;
+            while (scanner.isAsciiWhiteSpace(text[pos]))
+            {
+                pos++;
+            }
+
+            auto quote = text[pos];
+            if (quote != CharacterCodes::singleQuote && quote != CharacterCodes::doubleQuote)
+            {
+                continue;
+            }
+
+            // the value is not empty and it is on the same line
+            auto valueStart = pos + 1;
+            for (auto valueEnd = valueStart + 1;
+                 valueEnd < text.length() && !scanner.isLineBreak(text[valueEnd - 1]); valueEnd++)
+            {
+                if (text[valueEnd] == quote)
+                {
+                    match = {index, pos - index, text.substring(valueStart, valueEnd)};
+                    return true;
+                }
+            }
         }
 
-        string r;
-        r.append(S(R"((\s)"));
-        r.append(name);
-        r.append(S(R"(\s*=\s*)('|")(.+?)\2)"));
-        auto result = regex(r, std::regex_constants::ECMAScript);
-        namedArgRegExCache.insert({name, result});
-        return result;
+        return false;
     }
 
-    auto extractPragmas(std::vector<data::PragmaPseudoMapEntry> &pragmas, CommentRange range, string text) -> void
+    auto extractPragmas(std::vector<data::PragmaPseudoMapEntry> &pragmas, CommentRange range, safe_string text) -> void
     {
-        if (range->kind == SyntaxKind::SingleLineCommentTrivia)
+        string name;
+        if (range->kind == SyntaxKind::SingleLineCommentTrivia && matchTripleSlashXMLCommentStart(text, name))
         {
-            auto tripleSlashXMLComment_begin =
-                sregex_iterator(text.begin(), text.end(), tripleSlashXMLCommentStartRegEx);
-            auto tripleSlashXMLComment_end = sregex_iterator();
             // tripleSlash
-            if (tripleSlashXMLComment_begin != tripleSlashXMLComment_end)
+            if (name == S("reference"))
             {
-                for (sregex_iterator i = tripleSlashXMLComment_begin; i != tripleSlashXMLComment_end; ++i)
+                std::map<string, data::ArgumentWithCommentRange> _args;
+                for (auto arg : {S("types"), S("lib"), S("path"), S("no-default-lib")})
                 {
-                    smatch match = *i;
-                    string name = match[1].str();
-
-                    if (name == S("reference"))
+                    NamedArgMatch matchResult;
+                    if (!matchNamedArg(text, arg, matchResult))
                     {
-                        std::map<string, data::ArgumentWithCommentRange> _args;
-                        for (auto arg : {S("types"), S("lib"), S("path"), S("no-default-lib")})
-                        {
-                            auto matcher = getNamedArgRegEx(arg);
-                            auto matchResult_begin = sregex_iterator(text.begin(), text.end(), matcher);
-                            auto matchResult_end = sregex_iterator();
-                            if (matchResult_begin == matchResult_end)
-                            {
-                                continue;
-                            }
-
-                            smatch matchResult = *matchResult_begin;
-
-                            if (arg == string(S("no-default-lib")))
-                            {
-                                _args[arg] = {{matchResult[3], 0, 0}, range};
-                            }
-                            else
-                            {
-                                // span
-                                auto startPos = range->pos.pos + std::distance(matchResult_begin, matchResult_end) +
-                                                matchResult[1].length() + matchResult[2].length();
-                                _args[arg] = {
-                                    {matchResult[3], (int)startPos, (int)startPos + (int)matchResult[3].length()},
-                                    range};
-                            }
-                        }
+                        continue;
+                    }
 
-                        pragmas.push_back({name, _args});
+                    if (arg == string(S("no-default-lib")))
+                    {
+                        _args[arg] = {{matchResult.value, 0, 0}, range};
+                    }
+                    else
+                    {
+                        // span
+                        auto startPos = range->pos.pos + matchResult.index + matchResult.prefixLength + 1;
+                        _args[arg] = {{matchResult.value, startPos, startPos + (number)matchResult.value.size()},
+                                      range};
                     }
                 }
+
+                pragmas.push_back({name, _args});
             }
         }
 
@@ -8162,24 +8233,6 @@ struct Parser
 
 }; // End of Scanner
 
-// // Produces a new SourceFile for the 'newText' provided. The 'textChangeRange' parameter
-// // indicates what changed between the 'text' that this SourceFile has and the 'newText'.
-// // The SourceFile will be created with the compiler attempting to reuse.as<many>() nodes from
-// // this file.as<possible>().
-// //
-// // this Note auto mutates nodes from this SourceFile. That means any existing nodes
-// // from this SourceFile that are being held onto may change.as<a>() result (including
-// // becoming detached from any SourceFile).  It is recommended that this SourceFile not
-// // be used once 'update' is called on it.
-// auto updateSourceFile(SourceFile sourceFile, string newText, TextChangeRange textChangeRange, boolean
-// aggressiveChecks = false) -> SourceFile {
-//     auto newSourceFile = IncrementalParser::updateSourceFile(sourceFile, newText, textChangeRange, aggressiveChecks);
-//     // Because new source file node is created, it may not have the flag PossiblyContainDynamicImport. This is the
-//     case if there is no new edit to add dynamic import.
-//     // We will manually port the flag to the new source file.
-//     newSourceFile->flags |= (sourceFile->flags & NodeFlags::PermanentlySetIncrementalFlags);
-//     return newSourceFile;
-// }
 } // namespace Impl
 
 // See also `isExternalOrCommonJsModule` in utilities.ts
@@ -8195,19 +8248,37 @@ Parser::Parser()
 
 auto Parser::parseSourceFile(string sourceText, ScriptTarget languageVersion) -> SourceFile
 {
-    return impl->parseSourceFile(string(), sourceText, languageVersion, IncrementalParser::SyntaxCursor());
+    return parseSourceFile(string(), std::move(sourceText), languageVersion, IncrementalParser::SyntaxCursor());
 }
 
 auto Parser::parseSourceFile(string fileName, string sourceText, ScriptTarget languageVersion) -> SourceFile
 {
-    return impl->parseSourceFile(fileName, sourceText, languageVersion, IncrementalParser::SyntaxCursor());
+    return parseSourceFile(fileName, std::move(sourceText), languageVersion, IncrementalParser::SyntaxCursor());
 }
 
 auto Parser::parseSourceFile(string fileName, string sourceText, ScriptTarget languageVersion,
                              IncrementalParser::SyntaxCursor syntaxCursor, boolean setParentNodes,
                              ScriptKind scriptKind) -> SourceFile
 {
-    return impl->parseSourceFile(fileName, sourceText, languageVersion, syntaxCursor, setParentNodes, scriptKind);
+    // all nodes of the file are freed together with the file
+    auto nodeArena = std::make_shared<NodeArena>();
+    NodeArenaScope nodeArenaScope(nodeArena.get());
+
+    auto sourceFile = impl->parseSourceFile(fileName, std::move(sourceText), languageVersion, syntaxCursor,
+                                            setParentNodes, scriptKind);
+    sourceFile->nodeArena = nodeArena;
+    return sourceFile.as<SourceFile>();
+}
+
+auto Parser::updateSourceFile(SourceFile sourceFile, string newText, TextChangeRange textChangeRange,
+                              boolean aggressiveChecks) -> SourceFile
+{
+    auto newSourceFile =
+        IncrementalParser::updateSourceFile(*this, sourceFile, std::move(newText), textChangeRange, aggressiveChecks);
+    // Because new source file node is created, it may not have the flag PossiblyContainDynamicImport. This is the case
+    // if there is no new edit to add dynamic import. We will manually port the flag to the new source file.
+    newSourceFile->flags |= (sourceFile->flags & NodeFlags::PermanentlySetIncrementalFlags);
+    return newSourceFile;
 }
 
 auto Parser::tokenToText(SyntaxKind kind) -> string
@@ -8225,17 +8296,14 @@ auto Parser::getLineAndCharacterOfPosition(SourceFileLike sourceFile, number pos
     return impl->scanner.getLineAndCharacterOfPosition(sourceFile, position);
 }
 
-Parser::~Parser()
+auto Parser::getLineStarts(SourceFileLike sourceFile) -> const std::vector<number> &
 {
-    delete impl;
+    return impl->scanner.getLineStarts(sourceFile);
 }
 
-// TODO: temporary solution
-namespace IncrementalParser
-{
-auto createSyntaxCursor(SourceFile sourceFile) -> SyntaxCursor
+Parser::~Parser()
 {
-    return SyntaxCursor();
+    delete impl;
 }
-} // namespace IncrementalParser
+
 } // namespace ts
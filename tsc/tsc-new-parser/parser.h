@@ -53,12 +53,20 @@ class Parser
     auto parseSourceFile(string, string, ScriptTarget, IncrementalParser::SyntaxCursor, boolean = false, ScriptKind = ScriptKind::Unknown)
         -> SourceFile;
 
+    // Produces a new SourceFile for 'newText', 'textChangeRange' is the change between the text of 'sourceFile' and
+    // 'newText'. Nodes which are not affected by the change are reused, they are moved to the new file and
+    // 'sourceFile' must not be used after the call.
+    auto updateSourceFile(SourceFile, string, TextChangeRange, boolean = false) -> SourceFile;
+
     auto tokenToText(SyntaxKind kind) -> string;
 
     auto syntaxKindString(SyntaxKind kind) -> string;
 
     auto getLineAndCharacterOfPosition(SourceFileLike sourceFile, number position) -> LineAndCharacter;
 
+    // line starts are computed once and kept in the source file
+    auto getLineStarts(SourceFileLike sourceFile) -> const std::vector<number> &;
+
     ~Parser();
 };
 
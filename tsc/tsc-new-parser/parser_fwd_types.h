@@ -3,6 +3,7 @@
 
 #include "config.h"
 #include "enums.h"
+#include "node_arena.h"
 #include "scanner_enums.h"
 #include "undefined.h"
 
@@ -11,7 +12,7 @@
 #include <type_traits>
 
 #define REF_NAME(x) x##Ref
-#define REF_TYPE(x) std::shared_ptr<x>
+#define REF_TYPE(x) x *
 
 #define FORWARD_DECLARATION(x)                                                                                         \
     struct x;                                                                                                          \
@@ -59,22 +60,24 @@ template <typename T> struct ptr
 
     ptr(undefined_t) : instance(nullptr){};
 
-    ptr(const T &data) : instance(std::make_shared<T>(data)){};
+    ptr(const T &data) : instance(NodeArena::make<T>(data)){};
 
-    template <typename U> ptr(ptr<U> otherPtr) : instance(std::static_pointer_cast<T>(otherPtr.instance)){};
+    ptr(T &&data) : instance(NodeArena::make<T>(std::move(data))){};
 
-    template <typename U> ptr(REF_TYPE(U) & otherInstance) : instance(std::static_pointer_cast<T>(otherInstance)){};
+    template <typename U> ptr(ptr<U> otherPtr) : instance(static_cast<T *>(otherPtr.instance)){};
+
+    template <typename U> ptr(REF_TYPE(U) & otherInstance) : instance(static_cast<T *>(otherInstance)){};
 
     ~ptr() = default;
 
     inline auto operator->()
     {
-        return instance.operator->();
+        return instance;
     }
 
     auto operator=(undefined_t) -> ptr &
     {
-        instance.reset();
+        instance = nullptr;
         return *this;
     }
 
@@ -206,12 +209,34 @@ template <typename T> struct ptr
     template <typename U, typename D = typename U::data> inline auto is() -> boolean
     {
         // TODO: review and simplify using Kind
-        return !!std::dynamic_pointer_cast<D>(instance);
+        return !!dynamic_cast<D *>(instance);
     }
 
     REF_TYPE(T) instance;
 };
 
+/// ptr to the root of the tree (SourceFile) which keeps the arena of the nodes of the tree alive, nodes do not own
+/// each other, the arena is freed when the last owning ptr is gone
+template <typename T> struct owning_ptr : ptr<T>
+{
+    using ptr<T>::ptr;
+
+    owning_ptr() = default;
+
+    owning_ptr(undefined_t) : ptr<T>(){};
+
+    owning_ptr(ptr<T> otherPtr) : ptr<T>(otherPtr){};
+
+    auto operator=(undefined_t) -> owning_ptr &
+    {
+        ptr<T>::operator=(undefined);
+        arena.reset();
+        return *this;
+    }
+
+    std::shared_ptr<NodeArena> arena = this->instance ? this->instance->nodeArena.lock() : nullptr;
+};
+
 namespace ts
 {
 namespace data
@@ -925,7 +950,7 @@ POINTER(PackageId)
 POINTER(ResolvedModuleFull)
 POINTER(ResolvedTypeReferenceDirective)
 POINTER(PatternAmbientModule)
-POINTER(SourceFile)
+using SourceFile = owning_ptr<data::SourceFile>;
 
 POINTER(EntityName)
 POINTER(PropertyName)
@@ -1058,7 +1083,7 @@ template <typename T> using NodeArray = data::NodeArray<T>;
 using ModifiersArray = NodeArray<Modifier>;
 using DecoratorsArray = NodeArray<Decorator>;
 
-template <typename R = Node, typename T = Node> using ArrayFuncT = std::function<R(NodeArray<T>)>;
+template <typename R = Node, typename T = Node> using ArrayFuncT = std::function<R(NodeArray<T> &)>;
 
 template <typename R = Node, typename T = Node> using ArrayFuncWithParentT = std::function<R(NodeArray<T>, T)>;
 } // namespace ts
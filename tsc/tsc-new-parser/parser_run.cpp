@@ -8,6 +8,7 @@
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <unordered_set>
 
 #if __cplusplus >= 201703L
 #include <filesystem>
@@ -25,12 +26,8 @@ namespace fs = std::experimental::filesystem;
 
 using namespace ts;
 
-void printParser(const wchar_t *fileName, const wchar_t *str, boolean showLineCharPos)
+void printTree(ts::Parser &parser, ts::SourceFile sourceFile, boolean showLineCharPos)
 {
-    ts::Parser parser;
-    // auto sourceFile = parser.parseSourceFile(S("function f() { let i = 10; }"), ScriptTarget::Latest);
-    auto sourceFile = parser.parseSourceFile(fileName, str, ScriptTarget::Latest);
-
     ts::FuncT<> visitNode;
     ts::ArrayFuncT<> visitArray;
 
@@ -76,6 +73,54 @@ void printParser(const wchar_t *fileName, const wchar_t *str, boolean showLineCh
     auto result = ts::forEachChild(sourceFile.as<ts::Node>(), visitNode, visitArray);
 }
 
+void printParser(const wchar_t *fileName, const wchar_t *str, boolean showLineCharPos)
+{
+    ts::Parser parser;
+    // auto sourceFile = parser.parseSourceFile(S("function f() { let i = 10; }"), ScriptTarget::Latest);
+    auto sourceFile = parser.parseSourceFile(fileName, str, ScriptTarget::Latest);
+
+    printTree(parser, sourceFile, showLineCharPos);
+}
+
+void collectNodes(ts::Node node, std::unordered_set<ts::data::Node *> &nodes)
+{
+    nodes.insert(node.instance);
+    ts::forEachChild<ts::Node, ts::Node>(node, [&](ts::Node child) -> ts::Node {
+        collectNodes(child, nodes);
+        return undefined;
+    });
+}
+
+// replaces 'length' characters at 'start' with 'newText', prints the tree updated by the incremental parser and the
+// number of nodes of the old tree which were reused
+void printIncrementalParser(const wchar_t *fileName, const wchar_t *str, number start, number length,
+                            std::wstring newText, boolean showLineCharPos)
+{
+    ts::Parser parser;
+    auto sourceFile = parser.parseSourceFile(fileName, str, ScriptTarget::Latest);
+
+    std::unordered_set<ts::data::Node *> oldNodes;
+    collectNodes(sourceFile.as<ts::Node>(), oldNodes);
+
+    std::wstring text(str);
+    text.replace(start, length, newText);
+    auto newSourceFile =
+        parser.updateSourceFile(sourceFile, text, TextChangeRange(TextSpan(start, length), newText.size()));
+
+    printTree(parser, newSourceFile, showLineCharPos);
+
+    std::unordered_set<ts::data::Node *> newNodes;
+    collectNodes(newSourceFile.as<ts::Node>(), newNodes);
+
+    auto reused = 0;
+    for (auto node : newNodes)
+    {
+        reused += oldNodes.count(node);
+    }
+
+    std::cout << "Reused nodes: " << reused << " of " << newNodes.size() << std::endl;
+}
+
 void print(const wchar_t *fileName, const wchar_t *str, boolean showLineCharPos)
 {
     ts::Parser parser;
@@ -103,6 +148,20 @@ boolean hasOption(int argc, char **args, const char *option)
     return false;
 }
 
+const char *optionValue(int argc, char **args, const char *option)
+{
+    auto length = std::strlen(option);
+    for (auto i = 1; i < argc; i++)
+    {
+        if (std::strncmp(option, args[i], length) == 0 && args[i][length] == '=')
+        {
+            return args[i] + length + 1;
+        }
+    }
+
+    return nullptr;
+}
+
 char *firstNonOption(int argc, char **args)
 {
     for (auto i = 1; i < argc; i++)
@@ -127,13 +186,20 @@ int main(int argc, char **args)
     {
         auto hasLine = hasOption(argc, args, "--line");
         auto hasSource = hasOption(argc, args, "--source");
+        // --edit=<start>:<length>:<new text>
+        auto edit = optionValue(argc, args, "--edit");
 
         auto file = firstNonOption(argc, args);
         auto exists = file != nullptr && fs::exists(file);
         if (exists)
         {
             auto str = readFile(std::string(file));
-            if (hasSource)
+            number start, length, offset;
+            if (edit && std::sscanf(edit, "%d:%d:%n", &start, &length, &offset) == 2)
+            {
+                printIncrementalParser(ctow(file).c_str(), str.c_str(), start, length, ctow(edit + offset), hasLine);
+            }
+            else if (hasSource)
             {
                 print(ctow(file).c_str(), str.c_str(), hasLine);
             }
@@ -239,6 +239,7 @@ struct Node : TextRange
     ///* @internal */ PTR(InferenceContext) inferenceContext;  // Inference context for contextual type
     /* @internal */ InternalFlags internalFlags;
     /* @internal */ bool processed; // internal field to mark processed node
+    /* @internal */ bool intersectsChange = false; // node intersects the edit of the incremental parse, it can't be reused
 };
 
 struct JSDocContainer : Node
@@ -573,15 +574,13 @@ struct MethodSignature : SignatureDeclarationBase
 struct MethodDeclaration : FunctionLikeDeclarationBase /*, ObjectLiteralElement*/
 {
     // kind: SyntaxKind::MethodDeclaration;
-    /* @internal*/ PTR(ExclamationToken) exclamationToken; // Present for use with reporting a grammar error
+    // exclamationToken of FunctionLikeDeclarationBase is present for use with reporting a grammar error
 };
 
 struct ConstructorDeclaration : FunctionLikeDeclarationBase
 {
     // kind: SyntaxKind::Constructor;
-    /* @internal */ NodeArray<PTR(TypeParameterDeclaration)>
-        typeParameters;                 // Present for use with reporting a grammar error
-    /* @internal */ PTR(TypeNode) type; // Present for use with reporting a grammar error
+    // typeParameters and type of SignatureDeclarationBase are present for use with reporting a grammar error
 };
 
 /** For when we encounter a semicolon in a class declaration. ES6 allows these as class elements. */
@@ -594,8 +593,7 @@ struct AccessorDeclaration
     : FunctionLikeDeclarationBase /*, ObjectLiteralElement*/ // ClassElement and ObjectLiteralElement contains all
                                                              // fields in FunctionLikeDeclarationBase
 {
-    /* @internal */ NodeArray<PTR(TypeParameterDeclaration)>
-        typeParameters; // Present for use with reporting a grammar error
+    // typeParameters of SignatureDeclarationBase are present for use with reporting a grammar error
 };
 
 // See the comment on MethodDeclaration for the intuition behind GetAccessorDeclaration being a
@@ -2468,6 +2466,12 @@ struct SourceFile : SourceFileLike
     /* @internal */ PTR(EntityName) localJsxFragmentFactory;
 
     /* @internal */ ExportedModulesFromDeclarationEmit exportedModulesFromDeclarationEmit;
+
+    // Nodes of the file were moved to the file produced by IncrementalParser::updateSourceFile, the file can't be used
+    /* @internal */ bool hasBeenIncrementallyParsed = false;
+
+    // Arena with all nodes of the file (including this one), it is owned by ts::SourceFile returned by the parser
+    std::weak_ptr<NodeArena> nodeArena;
 };
 
 struct UnparsedSection : Node
@@ -82,6 +82,56 @@ std::map<string, SyntaxKind> Scanner::textToKeyword = {{S("abstract"), SyntaxKin
                                                        {S("await"), SyntaxKind::AwaitKeyword},
                                                        {S("of"), SyntaxKind::OfKeyword}};
 
+/// Keywords grouped by length and first letter. Most identifiers are rejected without any string comparison, the rest
+/// are compared with the (one or two) keywords of the same length and first letter.
+class KeywordTable
+{
+  public:
+    // Reserved words are between 2 and 12 characters long and start with a lowercase letter
+    static const size_t MinLength = 2;
+    static const size_t MaxLength = 12;
+
+    KeywordTable(const std::map<string, SyntaxKind> &keywords)
+    {
+        for (auto &keyword : keywords)
+        {
+            auto &text = keyword.first;
+            debug(text.size() >= MinLength && text.size() <= MaxLength && text[0] >= S('a') && text[0] <= S('z'));
+            buckets[text.size()][text[0] - S('a')].push_back({text, keyword.second});
+        }
+    }
+
+    auto lookup(const string &text) const -> SyntaxKind
+    {
+        auto len = text.size();
+        if (len < MinLength || len > MaxLength || text[0] < S('a') || text[0] > S('z'))
+        {
+            return SyntaxKind::Unknown;
+        }
+
+        for (auto &keyword : buckets[len][text[0] - S('a')])
+        {
+            if (std::char_traits<char_t>::compare(keyword.text.data() + 1, text.data() + 1, len - 1) == 0)
+            {
+                return keyword.kind;
+            }
+        }
+
+        return SyntaxKind::Unknown;
+    }
+
+  private:
+    struct Keyword
+    {
+        string text;
+        SyntaxKind kind;
+    };
+
+    std::vector<Keyword> buckets[MaxLength + 1][26];
+};
+
+static const KeywordTable keywordTable(Scanner::textToKeyword);
+
 std::map<string, SyntaxKind> Scanner::textToToken = {{S("abstract"), SyntaxKind::AbstractKeyword},
                                                      {S("any"), SyntaxKind::AnyKeyword},
                                                      {S("as"), SyntaxKind::AsKeyword},
@@ -925,16 +975,6 @@ std::vector<number> Scanner::unicodeESNextIdentifierPart = {
     126572, 126578, 126580, 126583, 126585, 126588, 126590, 126590, 126592, 126601, 126603, 126619, 126625, 126627, 126629, 126633, 126635,
     126651, 131072, 173782, 173824, 177972, 177984, 178205, 178208, 183969, 183984, 191456, 194560, 195101, 917760, 917999};
 
-/**
- * Test for whether a single line comment's text contains a directive.
- */
-regex Scanner::commentDirectiveRegExSingleLine = regex(S("^\\s*\\/\\/\\/?\\s*@(ts-expect-error|ts-ignore)"));
-
-/**
- * Test for whether a multi-line comment's last line contains a directive.
- */
-regex Scanner::commentDirectiveRegExMultiLine = regex(S("^\\s*(?:\\/|\\*)*\\s*@(ts-expect-error|ts-ignore)"));
-
 // Creates a scanner over a (possibly unspecified) range of a piece of text.
 Scanner::Scanner(ScriptTarget languageVersion, boolean skipTrivia, LanguageVariant languageVariant, string textInitial,
                  ErrorCallback onError, number start, number length)
@@ -1018,7 +1058,7 @@ auto Scanner::getNumericLiteralFlags() -> TokenFlags
     return tokenFlags & TokenFlags::NumericLiteralFlags;
 }
 
-auto Scanner::lookupInUnicodeMap(number code, std::vector<number> map) -> boolean
+auto Scanner::lookupInUnicodeMap(number code, const std::vector<number> &map) -> boolean
 {
     // Bail out quickly if it couldn't possibly be in the map.
     if (code < map[0])
@@ -1054,18 +1094,52 @@ auto Scanner::lookupInUnicodeMap(number code, std::vector<number> map) -> boolea
     return false;
 }
 
+UnicodeRangeTable::UnicodeRangeTable(const std::vector<number> &ranges) : ranges(ranges)
+{
+    std::vector<Block> planeBlocks(256, Block{});
+    for (size_t i = 0; i + 1 < ranges.size(); i += 2)
+    {
+        for (auto code = ranges[i]; code <= ranges[i + 1] && code < 0x10000; code++)
+        {
+            planeBlocks[code >> 8][(code & 0xff) >> 6] |= uint64_t(1) << (code & 0x3f);
+        }
+    }
+
+    for (auto i = 0; i < 256; i++)
+    {
+        auto found = std::find(blocks.begin(), blocks.end(), planeBlocks[i]);
+        blockIndex[i] = (uint8_t)(found - blocks.begin());
+        if (found == blocks.end())
+        {
+            blocks.push_back(planeBlocks[i]);
+        }
+    }
+}
+
+auto UnicodeRangeTable::containsAstral(number code) const -> boolean
+{
+    return Scanner::lookupInUnicodeMap(code, ranges);
+}
+
+const UnicodeRangeTable Scanner::unicodeES3IdentifierStartTable(unicodeES3IdentifierStart);
+const UnicodeRangeTable Scanner::unicodeES3IdentifierPartTable(unicodeES3IdentifierPart);
+const UnicodeRangeTable Scanner::unicodeES5IdentifierStartTable(unicodeES5IdentifierStart);
+const UnicodeRangeTable Scanner::unicodeES5IdentifierPartTable(unicodeES5IdentifierPart);
+const UnicodeRangeTable Scanner::unicodeESNextIdentifierStartTable(unicodeESNextIdentifierStart);
+const UnicodeRangeTable Scanner::unicodeESNextIdentifierPartTable(unicodeESNextIdentifierPart);
+
 /* @internal */ auto Scanner::isUnicodeIdentifierStart(CharacterCodes code, ScriptTarget languageVersion)
 {
-    return languageVersion >= ScriptTarget::ES2015 ? lookupInUnicodeMap((number)code, unicodeESNextIdentifierStart)
-           : languageVersion == ScriptTarget::ES5  ? lookupInUnicodeMap((number)code, unicodeES5IdentifierStart)
-                                                   : lookupInUnicodeMap((number)code, unicodeES3IdentifierStart);
+    return languageVersion >= ScriptTarget::ES2015 ? unicodeESNextIdentifierStartTable.contains((number)code)
+           : languageVersion == ScriptTarget::ES5  ? unicodeES5IdentifierStartTable.contains((number)code)
+                                                   : unicodeES3IdentifierStartTable.contains((number)code);
 }
 
 auto Scanner::isUnicodeIdentifierPart(CharacterCodes code, ScriptTarget languageVersion)
 {
-    return languageVersion >= ScriptTarget::ES2015 ? lookupInUnicodeMap((number)code, unicodeESNextIdentifierPart)
-           : languageVersion == ScriptTarget::ES5  ? lookupInUnicodeMap((number)code, unicodeES5IdentifierPart)
-                                                   : lookupInUnicodeMap((number)code, unicodeES3IdentifierPart);
+    return languageVersion >= ScriptTarget::ES2015 ? unicodeESNextIdentifierPartTable.contains((number)code)
+           : languageVersion == ScriptTarget::ES5  ? unicodeES5IdentifierPartTable.contains((number)code)
+                                                   : unicodeES3IdentifierPartTable.contains((number)code);
 }
 
 auto Scanner::makeReverseMap(std::map<string, SyntaxKind> source) -> std::map<SyntaxKind, string>
@@ -1080,14 +1154,17 @@ auto Scanner::makeReverseMap(std::map<string, SyntaxKind> source) -> std::map<Sy
 
 std::map<SyntaxKind, string> Scanner::tokenStrings = makeReverseMap(textToToken);
 
+// the maps are shared by scanners of all threads, operator[] would insert missing kinds
 auto Scanner::tokenToString(SyntaxKind t) -> string
 {
-    return tokenStrings[t];
+    auto it = tokenStrings.find(t);
+    return it != tokenStrings.end() ? it->second : string();
 }
 
 auto Scanner::syntaxKindString(SyntaxKind t) -> string
 {
-    return tokenToText[t];
+    auto it = tokenToText.find(t);
+    return it != tokenToText.end() ? it->second : string();
 }
 
 /* @internal */
@@ -1139,7 +1216,7 @@ auto Scanner::getPositionOfLineAndCharacter(SourceFileLike sourceFile, number li
 }
 
 /* @internal */
-auto Scanner::computePositionOfLineAndCharacter(std::vector<number> lineStarts, number line, number character, string debugText,
+auto Scanner::computePositionOfLineAndCharacter(const std::vector<number> &lineStarts, number line, number character, string debugText,
                                                 bool allowEdits) -> number
 {
     if (line < 0 || line >= lineStarts.size())
@@ -1180,23 +1257,18 @@ auto Scanner::computePositionOfLineAndCharacter(std::vector<number> lineStarts,
 }
 
 /* @internal */
-auto Scanner::getLineStarts(SourceFileLike sourceFile) -> std::vector<number>
+auto Scanner::getLineStarts(SourceFileLike sourceFile) -> const std::vector<number> &
 {
-    if (!sourceFile->lineMap.empty())
+    if (sourceFile->lineMap.empty())
     {
-        return sourceFile->lineMap;
+        sourceFile->lineMap = computeLineStarts(sourceFile->text);
     }
 
-    auto lineMap = computeLineStarts(sourceFile->text);
-    for (auto &item : lineMap)
-    {
-        sourceFile->lineMap.push_back(item);
-    }
     return sourceFile->lineMap;
 }
 
 /* @internal */
-auto Scanner::computeLineAndCharacterOfPosition(std::vector<number> lineStarts, number position) -> LineAndCharacter
+auto Scanner::computeLineAndCharacterOfPosition(const std::vector<number> &lineStarts, number position) -> LineAndCharacter
 {
     auto lineNumber = computeLineOfPosition(lineStarts, position);
     return LineAndCharacter({lineNumber, position - lineStarts[lineNumber]});
@@ -1206,7 +1278,7 @@ auto Scanner::computeLineAndCharacterOfPosition(std::vector<number> lineStarts,
  * @internal
  * We assume the first line starts at position 0 and 'position' is non-negative.
  */
-auto Scanner::computeLineOfPosition(std::vector<number> lineStarts, number position, number lowerBound) -> number
+auto Scanner::computeLineOfPosition(const std::vector<number> &lineStarts, number position, number lowerBound) -> number
 {
     auto lineNumber = binarySearch<number, number>(lineStarts, position, &identity<number>, &compareValues<number>, lowerBound);
     if (lineNumber < 0)
@@ -1229,7 +1301,7 @@ auto Scanner::getLinesBetweenPositions(SourceFileLike sourceFile, number pos1, n
 {
     if (pos1 == pos2)
         return 0;
-    auto lineStarts = getLineStarts(sourceFile);
+    auto &lineStarts = getLineStarts(sourceFile);
     auto lower = std::min(pos1, pos2);
     auto isNegative = lower == pos2;
     auto upper = isNegative ? pos1 : pos2;
@@ -1277,6 +1349,11 @@ auto Scanner::isLineBreak(CharacterCodes ch) -> boolean
            ch == CharacterCodes::paragraphSeparator;
 }
 
+auto Scanner::isAsciiWhiteSpace(CharacterCodes ch) -> boolean
+{
+    return (ch >= CharacterCodes::tab && ch <= CharacterCodes::carriageReturn) || ch == CharacterCodes::space;
+}
+
 auto Scanner::isDigit(CharacterCodes ch) -> boolean
 {
     return ch >= CharacterCodes::_0 && ch <= CharacterCodes::_9;
@@ -1494,30 +1571,37 @@ auto Scanner::scanConflictMarkerTrivia(safe_string &text, number pos, std::funct
     return pos;
 }
 
-regex Scanner::shebangTriviaRegex = regex(S("^#!.*"));
+/**
+ * Length of the shebang (#! till the end of the line) at the start of the text, 0 if there is no shebang.
+ */
+auto Scanner::getShebangLength(safe_string &text) -> number
+{
+    if (text[0] != CharacterCodes::hash || text[1] != CharacterCodes::exclamation)
+    {
+        return 0;
+    }
+
+    auto length = 2;
+    while (length < text.length() && !isLineBreak(text[length]))
+    {
+        length++;
+    }
+
+    return length;
+}
 
 /*@internal*/
-auto Scanner::isShebangTrivia(string &text, number pos) -> boolean
+auto Scanner::isShebangTrivia(safe_string &text, number pos) -> boolean
 {
     // Shebangs check must only be done at the start of the file
     debug(pos == 0);
-    return regex_search(text, shebangTriviaRegex);
+    return getShebangLength(text) > 0;
 }
 
 /*@internal*/
-auto Scanner::scanShebangTrivia(string &text, number pos) -> number
+auto Scanner::scanShebangTrivia(safe_string &text, number pos) -> number
 {
-    auto words_begin = sregex_iterator(text.begin(), text.end(), shebangTriviaRegex);
-    auto words_end = sregex_iterator();
-    for (auto i = words_begin; i != words_end; ++i)
-    {
-        auto match = *i;
-        auto match_str = match.str();
-        pos = pos + match_str.size();
-        return pos;
-    }
-
-    return pos;
+    return pos + getShebangLength(text);
 }
 
 auto Scanner::appendCommentRange(number pos, number end, SyntaxKind kind, boolean hasTrailingNewLine, number state,
@@ -1546,17 +1630,9 @@ auto Scanner::getTrailingCommentRanges(string &text, number pos) -> std::vector<
 }
 
 /** Optionally, get the shebang */
-auto Scanner::getShebang(string &text) -> string
+auto Scanner::getShebang(safe_string &text) -> string
 {
-    auto words_begin = sregex_iterator(text.begin(), text.end(), shebangTriviaRegex);
-    auto words_end = sregex_iterator();
-    for (auto i = words_begin; i != words_end; ++i)
-    {
-        auto match = *i;
-        return match.str();
-    }
-
-    return string();
+    return text.substring(0, getShebangLength(text));
 }
 
 auto Scanner::isIdentifierStart(CharacterCodes ch, ScriptTarget languageVersion) -> boolean
@@ -2210,20 +2286,12 @@ auto Scanner::scanIdentifierParts() -> string
 
 auto Scanner::getIdentifierToken() -> SyntaxKind
 {
-    // Reserved words are between 2 and 12 characters long and start with a lowercase letter
-    auto len = tokenValue.size();
-    if (len >= 2 && len <= 12)
+    auto keyword = keywordTable.lookup(tokenValue);
+    if (keyword != SyntaxKind::Unknown)
     {
-        auto ch = (CharacterCodes)tokenValue[0];
-        if (ch >= CharacterCodes::a && ch <= CharacterCodes::z)
-        {
-            auto keyword = textToKeyword[tokenValue];
-            if (keyword != SyntaxKind::Unknown)
-            {
-                return token = keyword;
-            }
-        }
+        return token = keyword;
     }
+
     return token = SyntaxKind::Identifier;
 }
 
@@ -2504,7 +2572,8 @@ auto Scanner::scan() -> SyntaxKind
                 }
 
                 commentDirectives =
-                    appendIfCommentDirective(commentDirectives, text.substring(tokenPos, pos), commentDirectiveRegExSingleLine, tokenPos);
+                    appendIfCommentDirective(commentDirectives, safe_string(text.begin() + tokenPos, pos - tokenPos),
+                                             /*multiLine*/ false, tokenPos);
 
                 if (_skipTrivia)
                 {
@@ -2546,8 +2615,9 @@ auto Scanner::scan() -> SyntaxKind
                     }
                 }
 
-                commentDirectives = appendIfCommentDirective(commentDirectives, text.substring(lastLineStart, pos),
-                                                             commentDirectiveRegExMultiLine, lastLineStart);
+                commentDirectives =
+                    appendIfCommentDirective(commentDirectives, safe_string(text.begin() + lastLineStart, pos - lastLineStart),
+                                             /*multiLine*/ true, lastLineStart);
 
                 if (!commentClosed)
                 {
@@ -3005,10 +3075,10 @@ auto Scanner::reScanSlashToken() -> SyntaxKind
     return token;
 }
 
-auto Scanner::appendIfCommentDirective(std::vector<CommentDirective> commentDirectives, string text, regex commentDirectiveRegEx,
+auto Scanner::appendIfCommentDirective(std::vector<CommentDirective> commentDirectives, safe_string text, boolean multiLine,
                                        number lineStart) -> std::vector<CommentDirective>
 {
-    auto type = getDirectiveFromComment(text, commentDirectiveRegEx);
+    auto type = getDirectiveFromComment(text, multiLine);
     if (type == CommentDirectiveType::Undefined)
     {
         return commentDirectives;
@@ -3018,22 +3088,60 @@ auto Scanner::appendIfCommentDirective(std::vector<CommentDirective> commentDire
     return commentDirectives;
 }
 
-auto Scanner::getDirectiveFromComment(string &text, regex commentDirectiveRegEx) -> CommentDirectiveType
+/**
+ * Test for whether a single line comment's text (^\s*\/\/\/?\s*@(ts-expect-error|ts-ignore)) or a multi-line
+ * comment's last line (^\s*(?:\/|\*)*\s*@(ts-expect-error|ts-ignore)) contains a directive.
+ */
+auto Scanner::getDirectiveFromComment(safe_string text, boolean multiLine) -> CommentDirectiveType
 {
-    auto words_begin = sregex_iterator(text.begin(), text.end(), commentDirectiveRegEx);
-    auto words_end = sregex_iterator();
-    if (words_begin == words_end)
+    auto pos = 0;
+    while (isAsciiWhiteSpace(text[pos]))
+    {
+        pos++;
+    }
+
+    if (multiLine)
+    {
+        while (text[pos] == CharacterCodes::slash || text[pos] == CharacterCodes::asterisk)
+        {
+            pos++;
+        }
+    }
+    else
+    {
+        if (text[pos] != CharacterCodes::slash || text[pos + 1] != CharacterCodes::slash)
+        {
+            return CommentDirectiveType::Undefined;
+        }
+
+        pos += text[pos + 2] == CharacterCodes::slash ? 3 : 2;
+    }
+
+    while (isAsciiWhiteSpace(text[pos]))
+    {
+        pos++;
+    }
+
+    if (text[pos] != CharacterCodes::at)
     {
         return CommentDirectiveType::Undefined;
     }
 
-    for (auto i = words_begin; i != words_end; ++i)
+    pos++;
+
+    auto startsWith = [&](const char_t *directive) {
+        auto length = (number)std::char_traits<char_t>::length(directive);
+        return text.length() - pos >= length &&
+               std::char_traits<char_t>::compare(text.begin() + pos, directive, length) == 0;
+    };
+
+    if (startsWith(S("ts-expect-error")))
     {
-        auto match = *i;
-        auto match_str = match.str();
-        if (match_str == S("ts-expect-error"))
-            return CommentDirectiveType::ExpectError;
+        return CommentDirectiveType::ExpectError;
+    }
 
+    if (startsWith(S("ts-ignore")))
+    {
         return CommentDirectiveType::Ignore;
     }
 
@@ -3357,6 +3465,12 @@ auto Scanner::clearCommentDirectives() -> void
 }
 
 auto Scanner::setText(string newText, number start, number length) -> void
+{
+    textValue = std::move(newText);
+    setText(safe_string(textValue), start, length);
+}
+
+auto Scanner::setText(safe_string newText, number start, number length) -> void
 {
     text = newText;
     end = length == -1 ? text.length() : start + length;
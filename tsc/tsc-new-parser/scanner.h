@@ -2,6 +2,7 @@
 #define SCANNER_H
 
 #include <algorithm>
+#include <array>
 #include <assert.h>
 #include <cstdint>
 #include <functional>
@@ -20,27 +21,27 @@
 
 namespace ts
 {
+/// Bounds checked view of the text, it does not copy the text (which must outlive the view).
 struct safe_string
 {
-    string value;
+    const char_t *value;
+    number size;
 
-    safe_string() : value{S("")}
+    safe_string() : value{S("")}, size{0}
     {
     }
 
-    safe_string(string value) : value{value}
+    safe_string(const string &text) : value{text.data()}, size{static_cast<number>(text.size())}
     {
     }
 
-    safe_string &operator=(string &value_)
+    safe_string(const char_t *value, number size) : value{value}, size{size}
     {
-        value = value_;
-        return *this;
     }
 
-    CharacterCodes operator[](number index)
+    CharacterCodes operator[](number index) const
     {
-        if ((size_t)index >= value.length())
+        if ((size_t)index >= (size_t)size)
         {
             return CharacterCodes::outOfBoundary;
         }
@@ -48,20 +49,30 @@ struct safe_string
         return (CharacterCodes)value[index];
     }
 
-    auto substring(number from, number to) -> string
+    auto substring(number from, number to) const -> string
     {
-        return value.substr(from, to - from);
+        return string(value + from, to - from);
     }
 
-    auto length() -> number
+    auto length() const -> number
     {
-        return value.length();
+        return size;
     }
 
-    operator string &()
+    auto begin() const -> const char_t *
     {
         return value;
     }
+
+    auto end() const -> const char_t *
+    {
+        return value + size;
+    }
+
+    operator string() const
+    {
+        return string(value, size);
+    }
 };
 
 template <typename T> bool operator!(NodeArray<T> &values)
@@ -192,6 +203,35 @@ static auto parsePseudoBigInt(string stringValue) -> string
     return base10Value;
 }
 
+/// Set of characters given by a Unicode range map (pairs of the first and the last code point of a range). Characters
+/// of the Basic Multilingual Plane are looked up in a two-level bitmap (blocks of 256 characters, equal blocks are
+/// stored once), the rest by binary search in the ranges.
+class UnicodeRangeTable
+{
+  public:
+    UnicodeRangeTable(const std::vector<number> &ranges);
+
+    auto contains(number code) const -> boolean
+    {
+        if ((unsigned)code < 0x10000)
+        {
+            auto &block = blocks[blockIndex[code >> 8]];
+            return (block[(code & 0xff) >> 6] >> (code & 0x3f)) & 1;
+        }
+
+        return containsAstral(code);
+    }
+
+  private:
+    using Block = std::array<uint64_t, 4>;
+
+    auto containsAstral(number code) const -> boolean;
+
+    const std::vector<number> &ranges;
+    std::vector<Block> blocks;
+    uint8_t blockIndex[256];
+};
+
 class Scanner
 {
   public:    
@@ -216,13 +256,19 @@ class Scanner
 
     static std::vector<number> unicodeESNextIdentifierPart;
 
-    static regex commentDirectiveRegExSingleLine;
+    static const UnicodeRangeTable unicodeES3IdentifierStartTable;
 
-    static regex commentDirectiveRegExMultiLine;
+    static const UnicodeRangeTable unicodeES3IdentifierPartTable;
 
-    static number mergeConflictMarkerLength;
+    static const UnicodeRangeTable unicodeES5IdentifierStartTable;
 
-    static regex shebangTriviaRegex;
+    static const UnicodeRangeTable unicodeES5IdentifierPartTable;
+
+    static const UnicodeRangeTable unicodeESNextIdentifierStartTable;
+
+    static const UnicodeRangeTable unicodeESNextIdentifierPartTable;
+
+    static number mergeConflictMarkerLength;
 
   protected:
     ScriptTarget languageVersion;
@@ -231,8 +277,9 @@ class Scanner
 
     LanguageVariant languageVariant;
 
-    // scanner text
+    // scanner text, it is a view of textValue or of the text set by setText(safe_string)
     safe_string text;
+    string textValue;
 
     // Current position (end position of text of current token)
     number pos;
@@ -296,7 +343,7 @@ class Scanner
     /* @internal */
     auto tokenIsIdentifierOrKeywordOrGreaterThan(SyntaxKind token) -> boolean;
 
-    auto lookupInUnicodeMap(number code, std::vector<number> map) -> boolean;
+    static auto lookupInUnicodeMap(number code, const std::vector<number> &map) -> boolean;
 
     /* @internal */ auto isUnicodeIdentifierStart(CharacterCodes code, ScriptTarget languageVersion);
 
@@ -317,20 +364,21 @@ class Scanner
     auto getPositionOfLineAndCharacter(SourceFileLike sourceFile, number line, number character, bool allowEdits = true) -> number;
 
     /* @internal */
-    auto computePositionOfLineAndCharacter(std::vector<number> lineStarts, number line, number character, string debugText,
+    auto computePositionOfLineAndCharacter(const std::vector<number> &lineStarts, number line, number character, string debugText,
                                            bool allowEdits = true) -> number;
 
     /* @internal */
-    auto getLineStarts(SourceFileLike sourceFile) -> std::vector<number>;
+    // computed once and kept in the source file (lineMap)
+    auto getLineStarts(SourceFileLike sourceFile) -> const std::vector<number> &;
 
     /* @internal */
-    auto computeLineAndCharacterOfPosition(std::vector<number> lineStarts, number position) -> LineAndCharacter;
+    auto computeLineAndCharacterOfPosition(const std::vector<number> &lineStarts, number position) -> LineAndCharacter;
 
     /**
      * @internal
      * We assume the first line starts at position 0 and 'position' is non-negative.
      */
-    auto computeLineOfPosition(std::vector<number> lineStarts, number position, number lowerBound = 0) -> number;
+    auto computeLineOfPosition(const std::vector<number> &lineStarts, number position, number lowerBound = 0) -> number;
 
     /** @internal */
     auto getLinesBetweenPositions(SourceFileLike sourceFile, number pos1, number pos2);
@@ -344,6 +392,10 @@ class Scanner
 
     auto isLineBreak(CharacterCodes ch) -> boolean;
 
+    /** Whitespace of the directive and pragma comments: tab, line feed, vertical tab, form feed, carriage return and
+     * space. */
+    auto isAsciiWhiteSpace(CharacterCodes ch) -> boolean;
+
     auto isDigit(CharacterCodes ch) -> boolean;
 
     auto isHexDigit(CharacterCodes ch) -> boolean;
@@ -364,10 +416,10 @@ class Scanner
         -> number;
 
     /*@internal*/
-    auto isShebangTrivia(string &text, number pos) -> boolean;
+    auto isShebangTrivia(safe_string &text, number pos) -> boolean;
 
     /*@internal*/
-    auto scanShebangTrivia(string &text, number pos) -> number;
+    auto scanShebangTrivia(safe_string &text, number pos) -> number;
 
     /**
      * Invokes a callback for each comment range following the provided position.
@@ -549,7 +601,7 @@ class Scanner
     auto getTrailingCommentRanges(string &text, number pos) -> std::vector<CommentRange>;
 
     /** Optionally, get the shebang */
-    auto getShebang(string &text) -> string;
+    auto getShebang(safe_string &text) -> string;
 
     auto isIdentifierStart(CharacterCodes ch, ScriptTarget languageVersion) -> boolean;
 
@@ -624,10 +676,12 @@ class Scanner
 
     auto reScanSlashToken() -> SyntaxKind;
 
-    auto appendIfCommentDirective(std::vector<CommentDirective> commentDirectives, string text, regex commentDirectiveRegEx,
+    auto appendIfCommentDirective(std::vector<CommentDirective> commentDirectives, safe_string text, boolean multiLine,
                                   number lineStart) -> std::vector<CommentDirective>;
 
-    auto getDirectiveFromComment(string &text, regex commentDirectiveRegEx) -> CommentDirectiveType;
+    auto getDirectiveFromComment(safe_string text, boolean multiLine) -> CommentDirectiveType;
+
+    auto getShebangLength(safe_string &text) -> number;
 
     auto reScanTemplateToken(boolean isTaggedTemplate) -> SyntaxKind;
 
@@ -651,7 +705,7 @@ class Scanner
 
     auto scanJsDocToken() -> SyntaxKind;
 
-    template <typename T> auto speculationHelper(std::function<T()> callback, boolean isLookahead) -> T
+    template <typename T, typename F> auto speculationHelper(F &&callback, boolean isLookahead) -> T
     {
         auto savePos = pos;
         auto saveStartPos = startPos;
@@ -675,7 +729,7 @@ class Scanner
         return result;
     }
 
-    template <typename T> auto scanRange(number start, number length, std::function<T()> callback) -> T
+    template <typename T, typename F> auto scanRange(number start, number length, F &&callback) -> T
     {
         auto saveEnd = end;
         auto savePos = pos;
@@ -701,12 +755,12 @@ class Scanner
         return result;
     }
 
-    template <typename T> auto lookAhead(std::function<T()> callback) -> T
+    template <typename T, typename F> auto lookAhead(F &&callback) -> T
     {
         return speculationHelper<T>(callback, /*isLookahead*/ true);
     }
 
-    template <typename T> auto tryScan(std::function<T()> callback) -> T
+    template <typename T, typename F> auto tryScan(F &&callback) -> T
     {
         return speculationHelper<T>(callback, /*isLookahead*/ false);
     }
@@ -719,6 +773,9 @@ class Scanner
 
     auto setText(string newText, number start = 0, number length = -1) -> void;
 
+    // scans the text without copying it, the text must not be changed or freed while it is scanned
+    auto setText(safe_string newText, number start = 0, number length = -1) -> void;
+
     auto setOnError(ErrorCallback errorCallback) -> void;
 
     auto setScriptTarget(ScriptTarget scriptTarget) -> void;
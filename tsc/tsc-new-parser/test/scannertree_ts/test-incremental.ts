@@ -0,0 +1,79 @@
+import * as fs from 'fs';
+import * as os from 'os';
+import * as path from 'path';
+import { execFileSync } from 'child_process';
+
+// Applies typical edits to the files of the folder, checks that the tree updated by the incremental parser
+// (tsc-new-parser --edit=<start>:<length>:<new text>) is the same as the tree of the full parse of the edited text
+// and that nodes of the old tree were reused.
+
+const parserExe = process.argv[3] || "C:/dev/TypeScriptCompiler/__build/tsc/tsc-new-parser/Debug/tsc-new-parser.exe";
+
+function getEdits(text: string) {
+    const lines = text.split("\n");
+    const middleLine = lines.slice(0, lines.length >> 1).reduce((pos, line) => pos + line.length + 1, 0);
+    const middle = text.length >> 1;
+    const identifier = /[A-Za-z_]\w*/g;
+    identifier.lastIndex = middle;
+    const match = identifier.exec(text);
+
+    const edits = [
+        // new statement
+        { start: middleLine, length: 0, newText: "let __edit = 1;\n" },
+        // typing a space
+        { start: middle, length: 0, newText: " " },
+        // deleting a character
+        { start: middle, length: 1, newText: "" },
+    ];
+
+    if (match) {
+        // renaming an identifier
+        edits.push({ start: match.index, length: match[0].length, newText: match[0] + "Renamed" });
+    }
+
+    return edits;
+}
+
+try {
+    const fld = process.argv[2] || "../../../test/tester/tests";
+    const editedFile = path.join(os.tmpdir(), "incremental_edited.ts");
+    const files = fs.readdirSync(fld);
+    for (const file of files) {
+        const text = fs.readFileSync(fld + "/" + file, "utf8");
+
+        // positions of the native parser are in UTF-16 code units, line breaks are not normalized
+        if (/[^\x00-\x7F]/.test(text) || text.indexOf("\r") >= 0) {
+            continue;
+        }
+
+        for (const edit of getEdits(text)) {
+            const editName = file + " @ " + edit.start + ":" + edit.length + ":" + JSON.stringify(edit.newText);
+            console.log("testing file ... edit: " + editName);
+
+            const newText = text.substring(0, edit.start) + edit.newText + text.substring(edit.start + edit.length);
+            fs.writeFileSync(editedFile, newText);
+
+            const output1 = execFileSync(parserExe, [editedFile]).toString();
+            const output2 = execFileSync(parserExe, ["--edit=" + edit.start + ":" + edit.length + ":" + edit.newText, fld + "/" + file]).toString();
+
+            const output2_lines = output2.split("\n");
+            const reusedLine = output2_lines.find(line => line.startsWith("Reused nodes:"));
+            const output2_tree = output2_lines.filter(line => line != reusedLine).join("\n");
+
+            if (output1 != output2_tree) {
+                console.log("Output full parse:", output1);
+                console.log("Output incremental parse:", output2_tree);
+                throw "Tree mismatched " + editName;
+            }
+
+            const reused = parseInt(reusedLine.split(" ")[2]);
+            console.log(reusedLine);
+            if (reused == 0 && text.length > 1000) {
+                throw "No nodes reused " + editName;
+            }
+        }
+    }
+}
+catch (err) {
+    console.error(err);
+}
@@ -0,0 +1,188 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "file_helper.h"
+#include "parser.h"
+
+using namespace ts;
+
+// Compares the matchers of comment directives, the shebang and triple-slash references (Scanner::getDirectiveFromComment,
+// Scanner::getShebangLength, pragmas of the parsed file) with the regular expressions they replace, on random comments
+// built from the pieces the expressions look for: random sequences of them and comments close to the matching ones
+// (a piece of a matching comment is dropped, replaced or preceded by another one sometimes).
+//
+// USAGE: tsc-new-parser-test-comments [count of comments, 300000 by default] [seed]
+
+static const std::wregex commentDirectiveRegExSingleLine(LR"(^\s*\/\/\/?\s*@(ts-expect-error|ts-ignore))");
+static const std::wregex commentDirectiveRegExMultiLine(LR"(^\s*(?:\/|\*)*\s*@(ts-expect-error|ts-ignore))");
+static const std::wregex shebangTriviaRegex(LR"(^#!.*)");
+static const std::wregex tripleSlashXMLCommentStartRegEx(LR"(^///\s*<(\S+)\s(.*)?/>)");
+
+static const std::vector<string> pieces = {
+    S("/"),          S("//"),    S("///"),       S("*"),    S(" "),  S("  "), S("\t"),      S("\v"),   S("\f"),
+    S("@"),          S("@"),     S("ts-ignore"), S("ts-expect-error"), S("ts-"), S("<"),  S(">"),       S("/>"),
+    S("reference"),  S("types"), S("lib"),       S("path"), S("no-default-lib"), S("="), S("'"),        S("\""),
+    S("#"),          S("!"),     S("#!"),        S("a"),    S("x.d.ts"),         S("amd-module"),       S("\u00e9"),
+    S("true"),
+};
+
+static const std::vector<std::vector<string>> shapes = {
+    {S("//"), S(" "), S("@"), S("ts-expect-error")},
+    {S("///"), S("@"), S("ts-ignore"), S(" "), S("a")},
+    {S(" "), S("*"), S("*"), S(" "), S("@"), S("ts-ignore")},
+    {S("/"), S("*"), S("\t"), S("@"), S("ts-expect-error"), S("*"), S("/")},
+    {S("#!"), S(" "), S("a")},
+    {S("/"), S(" "), S("<"), S("reference"), S(" "), S("path"), S("="), S("'"), S("x.d.ts"), S("'"), S(" "), S("/>")},
+    {S("/"), S("<"), S("reference"), S(" "), S("types"), S(" "), S("="), S(" "), S("\""), S("a"), S("\""), S(" "), S("lib"),
+     S("="), S("'"), S("a"), S("'"), S("/>")},
+    {S("/"), S("<"), S("reference"), S(" "), S("no-default-lib"), S("="), S("\""), S("true"), S("\""), S("/>")},
+    {S("/"), S("<"), S("amd-module"), S(" "), S("path"), S("="), S("'"), S("a"), S("'"), S("/>")},
+};
+
+static const std::vector<string> lineBreaks = {S("\n"), S("\r"), S("\u2028"), S("\u2029")};
+
+static auto directiveOf(const std::wregex &regex, const string &text) -> CommentDirectiveType
+{
+    std::wsmatch match;
+    if (!std::regex_search(text, match, regex))
+    {
+        return CommentDirectiveType::Undefined;
+    }
+
+    return match[1].str() == S("ts-expect-error") ? CommentDirectiveType::ExpectError : CommentDirectiveType::Ignore;
+}
+
+static auto fail(const char *what, const string &text) -> int
+{
+    std::cerr << "mismatch of " << what << " for: " << wstos(text) << std::endl;
+    return 1;
+}
+
+int main(int argc, char **args)
+{
+    auto count = argc > 1 ? std::atoi(args[1]) : 300000;
+    std::mt19937 random(argc > 2 ? std::atoi(args[2]) : 1);
+
+    auto randomPiece = [&](boolean withLineBreaks) {
+        return withLineBreaks && random() % 8 == 0 ? lineBreaks[random() % lineBreaks.size()] : pieces[random() % pieces.size()];
+    };
+
+    auto randomText = [&](boolean withLineBreaks) {
+        string text;
+        if (random() % 2)
+        {
+            auto length = random() % 12;
+            for (auto i = 0u; i < length; i++)
+            {
+                text += randomPiece(withLineBreaks);
+            }
+
+            return text;
+        }
+
+        for (auto &piece : shapes[random() % shapes.size()])
+        {
+            switch (random() % 16)
+            {
+            case 0:
+                break;
+            case 1:
+                text += randomPiece(withLineBreaks);
+                break;
+            case 2:
+                text += randomPiece(withLineBreaks);
+                text += piece;
+                break;
+            default:
+                text += piece;
+                break;
+            }
+        }
+
+        return text;
+    };
+
+    Scanner scanner(ScriptTarget::Latest, /*skipTrivia*/ true);
+    Parser parser;
+    auto failures = 0;
+    for (auto i = 0; i < count; i++)
+    {
+        auto text = randomText(/*withLineBreaks*/ true);
+        safe_string view(text.data(), (number)text.size());
+
+        if (scanner.getDirectiveFromComment(view, /*multiLine*/ false) !=
+            directiveOf(commentDirectiveRegExSingleLine, text))
+        {
+            failures += fail("single line comment directive", text);
+        }
+
+        if (scanner.getDirectiveFromComment(view, /*multiLine*/ true) != directiveOf(commentDirectiveRegExMultiLine, text))
+        {
+            failures += fail("multi-line comment directive", text);
+        }
+
+        std::wsmatch shebang;
+        auto shebangLength = std::regex_search(text, shebang, shebangTriviaRegex) ? shebang.length(0) : 0;
+        if (scanner.getShebangLength(view) != shebangLength)
+        {
+            failures += fail("shebang", text);
+        }
+
+        // a leading single line comment (the comment ends at a line break) of a file
+        auto comment = S("//") + randomText(/*withLineBreaks*/ false);
+        auto sourceFile = parser.parseSourceFile(S("comment.ts"), comment + S("\nlet a;\n"), ScriptTarget::Latest);
+        auto &pragmas = sourceFile->pragmas;
+
+        std::wsmatch tag;
+        auto isReference = std::regex_search(comment, tag, tripleSlashXMLCommentStartRegEx) && tag[1].str() == S("reference");
+        if (isReference != (pragmas.count(S("reference")) > 0))
+        {
+            failures += fail("triple-slash reference", comment);
+            continue;
+        }
+
+        if (!isReference)
+        {
+            continue;
+        }
+
+        auto &args = pragmas[S("reference")].front();
+        for (auto arg : {S("types"), S("lib"), S("path"), S("no-default-lib")})
+        {
+            std::wregex namedArgRegEx(S(R"((\s)") + string(arg) + S(R"(\s*=\s*)('|")(.+?)\2)"));
+            std::wsmatch namedArg;
+            auto found = args.find(arg);
+            if (!std::regex_search(comment, namedArg, namedArgRegEx))
+            {
+                if (found != args.end())
+                {
+                    failures += fail("named argument", comment);
+                }
+
+                continue;
+            }
+
+            if (found == args.end() || found->second._arg.value != namedArg[3].str())
+            {
+                failures += fail("named argument value", comment);
+                continue;
+            }
+
+            // the span of the value, in the comment at the start of the file
+            auto start = string(arg) == S("no-default-lib") ? 0 : namedArg.position(0) + namedArg.length(1) + namedArg.length(2);
+            auto end = string(arg) == S("no-default-lib") ? 0 : start + namedArg.length(3);
+            if (found->second._arg.pos != start || found->second._arg.end != end)
+            {
+                failures += fail("named argument span", comment);
+            }
+        }
+    }
+
+    std::cout << count << " comments, " << failures << " mismatches" << std::endl;
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,141 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if __cplusplus >= 201703L
+#include <filesystem>
+namespace fs = std::filesystem;
+#else
+#define _SILENCE_EXPERIMENTAL_FILESYSTEM_DEPRECATION_WARNING
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+#endif
+
+#include "file_helper.h"
+#include "parser.h"
+#include "utilities.h"
+
+using namespace ts;
+
+// Applies random edits to the files of the folder, a few edits in a row to the same tree, and checks that the tree
+// updated by Parser::updateSourceFile is the same as the tree of the full parse of the edited text.
+//
+// USAGE: tsc-new-parser-test-incremental <folder of .ts files> [count of edits, 1000 by default] [seed]
+
+static const std::vector<string> insertions = {
+    S(""),  S(" "), S("x"),  S("1"),  S(";"),  S(","),  S("."),     S("{"),         S("}"),      S("("),
+    S(")"), S("["), S("]"),  S("<"),  S(">"),  S("="),  S("\n"),    S("\""),        S("'"),      S("`"),
+    S("/*"), S("*/"), S("//"), S("${"), S("=>"), S("as"), S("let "), S("let y = 1;\n"), S("function g() {}\n"),
+    S("class C { m() {} }\n"),
+};
+
+static auto dump(Parser &parser, SourceFile sourceFile) -> std::string
+{
+    std::ostringstream out;
+    FuncT<> visitNode;
+    ArrayFuncT<> visitArray;
+
+    auto indent = 0;
+    visitNode = [&](Node child) -> Node {
+        out << std::string(indent, ' ') << wstos(parser.syntaxKindString(child)) << " [" << child->pos << " - "
+            << child->_end << "]\n";
+
+        indent++;
+        forEachChild(child, visitNode, visitArray);
+        indent--;
+        return undefined;
+    };
+
+    visitArray = [&](NodeArray<Node> array) -> Node {
+        out << std::string(indent, ' ') << "[" << array.pos << " - " << array._end << "]\n";
+        for (auto node : array)
+        {
+            visitNode(node);
+        }
+
+        return undefined;
+    };
+
+    visitNode(sourceFile.as<Node>());
+    out << "diagnostics: " << sourceFile->parseDiagnostics.size() << "\n";
+    return out.str();
+}
+
+int main(int argc, char **args)
+{
+    if (argc < 2)
+    {
+        std::cerr << "USAGE: " << args[0] << " <folder of .ts files> [count of edits] [seed]" << std::endl;
+        return 1;
+    }
+
+    auto count = argc > 2 ? std::atoi(args[2]) : 1000;
+    std::mt19937 random(argc > 3 ? std::atoi(args[3]) : 1);
+
+    std::vector<std::pair<std::string, string>> files;
+    for (auto &entry : fs::directory_iterator(args[1]))
+    {
+        if (entry.path().extension() != ".ts")
+        {
+            continue;
+        }
+
+        auto text = readFile(entry.path().string());
+
+        // positions of the tree are in UTF-16 code units
+        if (std::any_of(text.begin(), text.end(), [](char_t ch) { return ch > 0x7f; }))
+        {
+            continue;
+        }
+
+        files.push_back({entry.path().filename().string(), text});
+    }
+
+    if (files.empty())
+    {
+        std::cerr << "no files in " << args[1] << std::endl;
+        return 1;
+    }
+
+    auto failures = 0;
+    for (auto edit = 0; edit < count;)
+    {
+        auto &file = files[random() % files.size()];
+        auto text = file.second;
+
+        Parser parser;
+        auto sourceFile = parser.parseSourceFile(ctow(file.first.c_str()), text, ScriptTarget::Latest);
+
+        // edits in a row reuse the nodes of the updated trees
+        auto edits = 1 + random() % 3;
+        for (auto i = 0u; i < edits && edit < count; i++)
+        {
+            edit++;
+
+            auto start = (number)(random() % (text.size() + 1));
+            auto length = (number)std::min<size_t>(random() % 8, text.size() - start);
+            auto newText = insertions[random() % insertions.size()];
+
+            text.replace(start, length, newText);
+            sourceFile = parser.updateSourceFile(sourceFile, text, TextChangeRange(TextSpan(start, length), newText.size()));
+
+            Parser fullParser;
+            auto expected = dump(fullParser, fullParser.parseSourceFile(ctow(file.first.c_str()), text, ScriptTarget::Latest));
+            if (dump(parser, sourceFile) != expected)
+            {
+                std::cerr << "mismatch of " << file.first << " @ " << start << ":" << length << ":" << wstos(newText)
+                          << " (edit " << i + 1 << " in a row)" << std::endl;
+                failures++;
+                break;
+            }
+        }
+    }
+
+    std::cout << count << " edits, " << failures << " mismatches" << std::endl;
+    return failures ? 1 : 0;
+}
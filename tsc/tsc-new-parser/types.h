@@ -18,6 +18,26 @@ namespace ts
         number character;
     };
 
+    struct TextSpan {
+
+        TextSpan() = default;
+        TextSpan(number start, number length) : start(start), length(length) {};
+
+        number start;
+        number length;
+    };
+
+    struct TextChangeRange {
+
+        TextChangeRange() = default;
+        TextChangeRange(TextSpan span, number newLength) : span(span), newLength(newLength) {};
+
+        /** span of the old text which was replaced */
+        TextSpan span;
+        /** length of the new text which replaced the span */
+        number newLength;
+    };
+
     struct DiagnosticMessageStore
     {
         DiagnosticMessageStore() = default;
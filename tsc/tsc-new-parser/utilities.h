@@ -265,7 +265,13 @@ template <typename T> inline auto setTextRange(T range, TextRange location) -> T
 
 inline static auto hasJSDocNodes(Node node) -> boolean
 {
-    auto jsDoc = node.template as<JSDocContainer>()->jsDoc;
+    // tokens, clauses and some other nodes are not JSDoc containers
+    if (!node.template is<JSDocContainer>())
+    {
+        return false;
+    }
+
+    auto &jsDoc = node.template as<JSDocContainer>()->jsDoc;
     return !!jsDoc && jsDoc.size() > 0;
 }
 
@@ -284,7 +290,7 @@ template <typename R = Node, typename T = Node> static auto visitNode(FuncT<R, T
 }
 
 template <typename R = Node, typename T = Node>
-static auto visitNodes(FuncT<R, T> cbNode, ArrayFuncT<R, T> cbNodes, NodeArray<T> nodes) -> R
+static auto visitNodes(FuncT<R, T> cbNode, ArrayFuncT<R, T> cbNodes, NodeArray<T> &nodes) -> R
 {
     if (!!nodes)
     {
@@ -305,13 +311,18 @@ static auto visitNodes(FuncT<R, T> cbNode, ArrayFuncT<R, T> cbNodes, NodeArray<T
     return undefined;
 }
 
-template <typename R, typename T, typename U> static auto visitNodes(FuncT<R, T> cbNode, ArrayFuncT<R, T> cbNodes, NodeArray<U> nodes) -> R
+template <typename R, typename T, typename U> static auto visitNodes(FuncT<R, T> cbNode, ArrayFuncT<R, T> cbNodes, NodeArray<U> &nodes) -> R
 {
     if (!!nodes)
     {
         if (cbNodes)
         {
-            return cbNodes(NodeArray<T>(nodes));
+            // the incremental parser moves arrays, the range of the copy is written back
+            NodeArray<T> array(nodes);
+            auto result = cbNodes(array);
+            nodes.pos = array.pos;
+            nodes._end = array._end;
+            return result;
         }
         for (auto node : nodes)
         {
@@ -1510,8 +1521,35 @@ inline auto nodeIsPresent(Node node) -> boolean
     return !nodeIsMissing(node);
 }
 
+inline auto containsParseError(Node node) -> boolean;
+
+inline auto aggregateChildData(Node node) -> void
+{
+    if ((node->flags & NodeFlags::HasAggregatedChildData) == NodeFlags::None)
+    {
+        // A node is considered to contain a parse error if:
+        //  a) the parser explicitly marked that it had an error
+        //  b) any of it's children reported that it had an error.
+        auto thisNodeOrAnySubNodesHasError =
+            (node->flags & NodeFlags::ThisNodeHasError) != NodeFlags::None ||
+            !!forEachChild<Node, Node>(node, [](Node child) -> Node { return containsParseError(child) ? child : undefined; });
+
+        // If so, mark ourselves accordingly.
+        if (thisNodeOrAnySubNodesHasError)
+        {
+            node->flags |= NodeFlags::ThisNodeOrAnySubNodesHasError;
+        }
+
+        // Also mark that we've propagated the child information to this node.  This way we can
+        // always consult the bit directly on this node without needing to check its children
+        // again.
+        node->flags |= NodeFlags::HasAggregatedChildData;
+    }
+}
+
 inline auto containsParseError(Node node) -> boolean
 {
+    aggregateChildData(node);
     return (node->flags & NodeFlags::ThisNodeOrAnySubNodesHasError) != NodeFlags::None;
 }
 
@@ -0,0 +1,356 @@
+#include "TypeScript/CompileCache.h"
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/SHA1.h"
+#include "llvm/Support/raw_ostream.h"
+
+#define DEBUG_TYPE "tsc"
+
+#define DEPENDENCIES_EXT ".deps"
+#define IMPORTED_MODULE_PREFIX "import:"
+#define JIT_OBJECT_PREFIX "jit-"
+#define JIT_OBJECT_EXT ".jit.o"
+#define TEMP_FILE_PREFIX "tmp-"
+
+namespace typescript
+{
+
+static std::string getCompilerBuildId()
+{
+    // any rebuild of the compiler changes size or time of the executable
+    auto mainExecutable =
+        llvm::sys::fs::getMainExecutable(nullptr, reinterpret_cast<void *>(&getCompilerBuildId));
+    llvm::sys::fs::file_status status;
+    if (mainExecutable.empty() || llvm::sys::fs::status(mainExecutable, status))
+    {
+        return "<unknown>";
+    }
+
+    return llvm::formatv("{0}:{1}:{2}", mainExecutable, status.getSize(),
+                         status.getLastModificationTime().time_since_epoch().count())
+        .str();
+}
+
+static std::string hashOf(llvm::StringRef data)
+{
+    llvm::SHA1 hasher;
+    hasher.update(data);
+    return llvm::toHex(hasher.final(), /*LowerCase=*/true);
+}
+
+static std::string createTempFilePath(llvm::StringRef cacheDir, llvm::StringRef ext)
+{
+    llvm::sys::fs::create_directories(cacheDir);
+
+    llvm::SmallString<256> model(cacheDir);
+    llvm::sys::path::append(model, TEMP_FILE_PREFIX "%%%%%%%%" + ext);
+
+    llvm::SmallString<256> tempPath;
+    llvm::sys::fs::createUniquePath(model, tempPath, /*MakeAbsolute=*/false);
+    return tempPath.str().str();
+}
+
+// used entries get new modification time, it is the order of eviction
+static void touch(llvm::StringRef path)
+{
+    int fd;
+    if (llvm::sys::fs::openFileForWrite(path, fd, llvm::sys::fs::CD_OpenExisting, llvm::sys::fs::OF_Append))
+    {
+        return;
+    }
+
+    llvm::sys::fs::setLastAccessAndModificationTime(fd, std::chrono::system_clock::now());
+    llvm::sys::Process::SafelyCloseFileDescriptor(fd);
+}
+
+bool CompileCache::lookup(llvm::StringRef fileName, llvm::StringRef source, llvm::StringRef optionsKey,
+                          llvm::StringRef extParam)
+{
+    ext = extParam.str();
+    artifactPath.clear();
+    importedModules.clear();
+
+    llvm::SmallString<256> absFileName(fileName);
+    llvm::sys::fs::make_absolute(absFileName);
+
+    llvm::SHA1 hasher;
+    hasher.update(getCompilerBuildId());
+    hasher.update(optionsKey);
+    hasher.update(absFileName);
+    hasher.update(hashOf(source));
+    inputKey = llvm::toHex(hasher.final(), /*LowerCase=*/true);
+
+    llvm::SmallString<256> dependenciesPath(cacheDir);
+    llvm::sys::path::append(dependenciesPath, inputKey + DEPENDENCIES_EXT);
+
+    auto fileOrErr = llvm::MemoryBuffer::getFile(dependenciesPath);
+    if (!fileOrErr)
+    {
+        return false;
+    }
+
+    llvm::SmallVector<llvm::StringRef> lines;
+    fileOrErr.get()->getBuffer().split(lines, '\n', -1, false);
+    std::vector<std::string> dependencies;
+    std::vector<std::string> recordedImportedModules;
+    for (auto line : lines)
+    {
+        if (line.consume_front(IMPORTED_MODULE_PREFIX))
+        {
+            recordedImportedModules.push_back(line.str());
+            continue;
+        }
+
+        dependencies.push_back(line.str());
+    }
+
+    std::string artifactKey;
+    if (!calculateArtifactKey(dependencies, artifactKey))
+    {
+        return false;
+    }
+
+    llvm::SmallString<256> path(cacheDir);
+    llvm::sys::path::append(path, artifactKey + ext);
+    if (!llvm::sys::fs::exists(path))
+    {
+        return false;
+    }
+
+    LLVM_DEBUG(llvm::dbgs() << "cache hit: " << fileName << " -> " << path << "\n";);
+
+    touch(dependenciesPath);
+    touch(path);
+
+    artifactPath = path.str().str();
+    importedModules = std::move(recordedImportedModules);
+    return true;
+}
+
+bool CompileCache::store(llvm::ArrayRef<std::string> dependencies, llvm::StringRef producedFilePath,
+                         llvm::ArrayRef<std::string> importedModulesParam)
+{
+    if (inputKey.empty())
+    {
+        return false;
+    }
+
+    std::string artifactKey;
+    if (!calculateArtifactKey(dependencies, artifactKey))
+    {
+        return false;
+    }
+
+    // write into temporary files first and rename them, so concurrent compilations never see partial entry
+    llvm::SmallString<256> path(cacheDir);
+    llvm::sys::path::append(path, artifactKey + ext);
+    auto tempArtifactPath = getTempFilePath();
+    if (llvm::sys::fs::copy_file(producedFilePath, tempArtifactPath) || llvm::sys::fs::rename(tempArtifactPath, path))
+    {
+        llvm::sys::fs::remove(tempArtifactPath);
+        return false;
+    }
+
+    llvm::SmallString<256> dependenciesPath(cacheDir);
+    llvm::sys::path::append(dependenciesPath, inputKey + DEPENDENCIES_EXT);
+    auto tempDependenciesPath = getTempFilePath();
+
+    {
+        std::error_code ec;
+        llvm::raw_fd_ostream os(tempDependenciesPath, ec, llvm::sys::fs::OF_Text);
+        if (ec)
+        {
+            return false;
+        }
+
+        for (auto &dependency : dependencies)
+        {
+            os << dependency << "\n";
+        }
+
+        for (auto &importedModule : importedModulesParam)
+        {
+            os << IMPORTED_MODULE_PREFIX << importedModule << "\n";
+        }
+    }
+
+    if (llvm::sys::fs::rename(tempDependenciesPath, dependenciesPath))
+    {
+        llvm::sys::fs::remove(tempDependenciesPath);
+        return false;
+    }
+
+    LLVM_DEBUG(llvm::dbgs() << "cache store: " << path << "\n";);
+
+    artifactPath = path.str().str();
+    importedModules.assign(importedModulesParam.begin(), importedModulesParam.end());
+    return true;
+}
+
+std::string CompileCache::getTempFilePath()
+{
+    return createTempFilePath(cacheDir, ext);
+}
+
+bool CompileCache::calculateArtifactKey(llvm::ArrayRef<std::string> dependencies, std::string &artifactKey)
+{
+    llvm::SHA1 hasher;
+    hasher.update(inputKey);
+    for (auto &dependency : dependencies)
+    {
+        auto fileOrErr = llvm::MemoryBuffer::getFile(dependency);
+        if (!fileOrErr)
+        {
+            return false;
+        }
+
+        hasher.update(dependency);
+        hasher.update(hashOf(fileOrErr.get()->getBuffer()));
+    }
+
+    artifactKey = llvm::toHex(hasher.final(), /*LowerCase=*/true);
+    return true;
+}
+
+void CompileCache::prune(llvm::StringRef cacheDir, uint64_t maxSize)
+{
+    struct Entry
+    {
+        std::string path;
+        uint64_t size;
+        llvm::sys::TimePoint<> lastUsed;
+    };
+
+    std::vector<Entry> entries;
+    uint64_t totalSize = 0;
+
+    std::error_code ec;
+    for (llvm::sys::fs::directory_iterator it(cacheDir, ec), end; it != end && !ec; it.increment(ec))
+    {
+        // files being written by running compilations
+        if (llvm::sys::path::filename(it->path()).startswith(TEMP_FILE_PREFIX))
+        {
+            continue;
+        }
+
+        llvm::sys::fs::file_status status;
+        if (llvm::sys::fs::status(it->path(), status) || status.type() != llvm::sys::fs::file_type::regular_file)
+        {
+            continue;
+        }
+
+        entries.push_back({it->path(), status.getSize(), status.getLastModificationTime()});
+        totalSize += status.getSize();
+    }
+
+    if (totalSize <= maxSize)
+    {
+        return;
+    }
+
+    llvm::sort(entries, [](const Entry &left, const Entry &right) { return left.lastUsed < right.lastUsed; });
+
+    for (auto &entry : entries)
+    {
+        if (totalSize <= maxSize)
+        {
+            break;
+        }
+
+        LLVM_DEBUG(llvm::dbgs() << "cache evict: " << entry.path << "\n";);
+
+        if (!llvm::sys::fs::remove(entry.path))
+        {
+            totalSize -= entry.size;
+        }
+    }
+}
+
+std::string JitObjectCache::getModuleKey(const llvm::Module &module)
+{
+    llvm::SmallString<0> bitcode;
+    llvm::raw_svector_ostream os(bitcode);
+    llvm::WriteBitcodeToFile(module, os);
+
+    llvm::SHA1 hasher;
+    hasher.update(getCompilerBuildId());
+    hasher.update(optionsKey);
+    hasher.update(bitcode);
+    return JIT_OBJECT_PREFIX + llvm::toHex(hasher.final(), /*LowerCase=*/true);
+}
+
+bool JitObjectCache::contains(llvm::StringRef moduleKey)
+{
+    return llvm::sys::fs::exists(getObjectPath(moduleKey));
+}
+
+void JitObjectCache::notifyObjectCompiled(const llvm::Module *module, llvm::MemoryBufferRef obj)
+{
+    auto moduleKey = module->getModuleIdentifier();
+    if (!llvm::StringRef(moduleKey).startswith(JIT_OBJECT_PREFIX))
+    {
+        return;
+    }
+
+    auto tempPath = createTempFilePath(cacheDir, JIT_OBJECT_EXT);
+
+    {
+        std::error_code ec;
+        llvm::raw_fd_ostream os(tempPath, ec, llvm::sys::fs::OF_None);
+        if (ec)
+        {
+            return;
+        }
+
+        os << obj.getBuffer();
+    }
+
+    auto path = getObjectPath(moduleKey);
+    if (llvm::sys::fs::rename(tempPath, path))
+    {
+        llvm::sys::fs::remove(tempPath);
+        return;
+    }
+
+    LLVM_DEBUG(llvm::dbgs() << "jit cache store: " << path << "\n";);
+}
+
+std::unique_ptr<llvm::MemoryBuffer> JitObjectCache::getObject(const llvm::Module *module)
+{
+    auto moduleKey = module->getModuleIdentifier();
+    if (!llvm::StringRef(moduleKey).startswith(JIT_OBJECT_PREFIX))
+    {
+        return nullptr;
+    }
+
+    auto path = getObjectPath(moduleKey);
+    auto fileOrErr = llvm::MemoryBuffer::getFile(path);
+    if (!fileOrErr)
+    {
+        return nullptr;
+    }
+
+    LLVM_DEBUG(llvm::dbgs() << "jit cache hit: " << path << "\n";);
+
+    touch(path);
+
+    return std::move(fileOrErr.get());
+}
+
+std::string JitObjectCache::getObjectPath(llvm::StringRef moduleKey)
+{
+    llvm::SmallString<256> path(cacheDir);
+    llvm::sys::path::append(path, moduleKey + JIT_OBJECT_EXT);
+    return path.str().str();
+}
+
+} // namespace typescript
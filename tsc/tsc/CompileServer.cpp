@@ -0,0 +1,612 @@
+#include "TypeScript/CompileServer.h"
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <set>
+#include <vector>
+
+#ifndef WIN32
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#define DEBUG_TYPE "tsc"
+
+namespace typescript
+{
+
+#ifdef WIN32
+
+int runCompileServer(llvm::StringRef socketPath, const CompileServerOptions &options, llvm::function_ref<void()> initWorker,
+                     llvm::function_ref<int(llvm::ArrayRef<std::string>)> handler)
+{
+    llvm::errs() << "Compile server is not supported on this platform\n";
+    return -1;
+}
+
+int runInChildProcess(llvm::function_ref<int()> action)
+{
+    return action();
+}
+
+int runCompileServerClient(llvm::StringRef socketPath, llvm::ArrayRef<std::string> args)
+{
+    llvm::errs() << "Compile server is not supported on this platform\n";
+    return -1;
+}
+
+#else
+
+// Message layout: header (payload size) sent together with client's stdin, stdout and stderr descriptors, then
+// payload - zero terminated strings: working folder and arguments. Reply is exit code.
+
+// the default socket is in the folder accessible to the user only: $XDG_RUNTIME_DIR or tsc-<uid> in temp folder
+static std::string getDefaultSocketPath()
+{
+    llvm::SmallString<256> path;
+    auto runtimeDir = getenv("XDG_RUNTIME_DIR");
+    if (runtimeDir && *runtimeDir)
+    {
+        path = runtimeDir;
+    }
+    else
+    {
+        llvm::sys::path::system_temp_directory(/*ErasedOnReboot=*/true, path);
+        llvm::sys::path::append(path, "tsc-" + std::to_string(geteuid()));
+    }
+
+    llvm::sys::path::append(path, "tsc-server.sock");
+    return path.str().str();
+}
+
+// checks that nobody else can create the socket in the folder of the default socket (or replace it)
+static bool checkSocketFolder(llvm::StringRef socketPath, bool create)
+{
+    auto folder = llvm::sys::path::parent_path(socketPath).str();
+    if (create && mkdir(folder.c_str(), 0700) && errno != EEXIST)
+    {
+        llvm::errs() << "Can't create folder " << folder << ": " << strerror(errno) << "\n";
+        return false;
+    }
+
+    struct stat folderStat;
+    if (lstat(folder.c_str(), &folderStat))
+    {
+        llvm::errs() << "Can't access folder " << folder << ": " << strerror(errno) << "\n";
+        return false;
+    }
+
+    if (!S_ISDIR(folderStat.st_mode) || folderStat.st_uid != geteuid() || (folderStat.st_mode & 077))
+    {
+        llvm::errs() << "Folder " << folder << " of the compile server socket must be owned by the user and be accessible to "
+                     << "the user only\n";
+        return false;
+    }
+
+    return true;
+}
+
+// requests are accepted from the same user only, the client sends requests to the server of the same user only
+static bool isPeerOfSameUser(int fd)
+{
+#ifdef __linux__
+    ucred credentials;
+    socklen_t length = sizeof(credentials);
+    if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &credentials, &length))
+    {
+        return false;
+    }
+
+    return credentials.uid == geteuid();
+#else
+    uid_t uid;
+    gid_t gid;
+    if (getpeereid(fd, &uid, &gid))
+    {
+        return false;
+    }
+
+    return uid == geteuid();
+#endif
+}
+
+// socket which nobody listens on, it is left by the previous run of the server
+static bool isStaleSocket(const sockaddr_un &addr)
+{
+    struct stat socketStat;
+    if (lstat(addr.sun_path, &socketStat) || !S_ISSOCK(socketStat.st_mode) || socketStat.st_uid != geteuid())
+    {
+        return false;
+    }
+
+    auto fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    auto refused = connect(fd, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) && errno == ECONNREFUSED;
+    close(fd);
+    return refused;
+}
+
+static bool initAddress(llvm::StringRef socketPath, sockaddr_un &addr)
+{
+    if (socketPath.size() >= sizeof(addr.sun_path))
+    {
+        llvm::errs() << "Socket path is too long: " << socketPath << "\n";
+        return false;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, socketPath.data(), socketPath.size());
+    return true;
+}
+
+static bool readAll(int fd, void *data, size_t size)
+{
+    auto ptr = static_cast<char *>(data);
+    while (size > 0)
+    {
+        auto read = ::read(fd, ptr, size);
+        if (read <= 0)
+        {
+            return false;
+        }
+
+        ptr += read;
+        size -= read;
+    }
+
+    return true;
+}
+
+static bool writeAll(int fd, const void *data, size_t size)
+{
+    auto ptr = static_cast<const char *>(data);
+    while (size > 0)
+    {
+        auto written = ::write(fd, ptr, size);
+        if (written <= 0)
+        {
+            return false;
+        }
+
+        ptr += written;
+        size -= written;
+    }
+
+    return true;
+}
+
+static bool receiveRequest(int clientFd, std::vector<std::string> &strings, int (&fds)[3])
+{
+    uint32_t payloadSize = 0;
+    iovec iov{&payloadSize, sizeof(payloadSize)};
+
+    char control[CMSG_SPACE(sizeof(fds))];
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    if (recvmsg(clientFd, &msg, MSG_WAITALL) != sizeof(payloadSize))
+    {
+        return false;
+    }
+
+    auto cmsg = CMSG_FIRSTHDR(&msg);
+    if (!cmsg || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS || cmsg->cmsg_len != CMSG_LEN(sizeof(fds)))
+    {
+        return false;
+    }
+
+    memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+
+    std::vector<char> payload(payloadSize);
+    if (!readAll(clientFd, payload.data(), payload.size()))
+    {
+        for (auto fd : fds)
+        {
+            close(fd);
+        }
+
+        return false;
+    }
+
+    for (auto it = payload.begin(); it != payload.end();)
+    {
+        auto end = std::find(it, payload.end(), '\0');
+        strings.emplace_back(it, end);
+        it = end == payload.end() ? end : end + 1;
+    }
+
+    return !strings.empty();
+}
+
+static void flushOutput()
+{
+    fflush(stdout);
+    fflush(stderr);
+    llvm::outs().flush();
+    llvm::errs().flush();
+}
+
+static int processRequest(int clientFd, llvm::function_ref<int(llvm::ArrayRef<std::string>)> handler)
+{
+    std::vector<std::string> strings;
+    int fds[3];
+    if (!receiveRequest(clientFd, strings, fds))
+    {
+        llvm::errs() << "Bad request\n";
+        return -1;
+    }
+
+    auto &workingDir = strings.front();
+    llvm::ArrayRef<std::string> args(strings);
+    args = args.drop_front();
+
+    LLVM_DEBUG(llvm::dbgs() << "request in: " << workingDir << "\n";);
+
+    llvm::SmallString<256> serverWorkingDir;
+    llvm::sys::fs::current_path(serverWorkingDir);
+
+    // redirect input ('-' as the input file) and output to the client
+    flushOutput();
+
+    auto savedStdin = dup(STDIN_FILENO);
+    auto savedStdout = dup(STDOUT_FILENO);
+    auto savedStderr = dup(STDERR_FILENO);
+    dup2(fds[0], STDIN_FILENO);
+    dup2(fds[1], STDOUT_FILENO);
+    dup2(fds[2], STDERR_FILENO);
+    for (auto fd : fds)
+    {
+        close(fd);
+    }
+
+    llvm::sys::fs::set_current_path(workingDir);
+
+    auto result = handler(args);
+
+    flushOutput();
+
+    dup2(savedStdin, STDIN_FILENO);
+    dup2(savedStdout, STDOUT_FILENO);
+    dup2(savedStderr, STDERR_FILENO);
+    close(savedStdin);
+    close(savedStdout);
+    close(savedStderr);
+
+    llvm::sys::fs::set_current_path(serverWorkingDir);
+
+    return result;
+}
+
+// serves requests until it is replaced, the result is the exit code of the worker, 0 if it is to be replaced
+static int runWorker(int serverFd, const CompileServerOptions &options, llvm::function_ref<void()> initWorker,
+                     llvm::function_ref<int(llvm::ArrayRef<std::string>)> handler)
+{
+    initWorker();
+
+    unsigned requests = 0;
+    while (!options.maxRequests || requests < options.maxRequests)
+    {
+        auto clientFd = accept(serverFd, nullptr, nullptr);
+        if (clientFd < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+            {
+                continue;
+            }
+
+            llvm::errs() << "Can't accept connection: " << strerror(errno) << "\n";
+            return 1;
+        }
+
+        if (!isPeerOfSameUser(clientFd))
+        {
+            llvm::errs() << "Connection of another user is rejected\n";
+            close(clientFd);
+            continue;
+        }
+
+        int32_t result = processRequest(clientFd, handler);
+        writeAll(clientFd, &result, sizeof(result));
+        close(clientFd);
+
+        requests++;
+        if (options.maxMemory && llvm::sys::Process::GetMallocUsage() > options.maxMemory)
+        {
+            break;
+        }
+    }
+
+    return 0;
+}
+
+// set by SIGTERM and SIGINT, the server stops its workers and removes the socket
+static volatile sig_atomic_t stopRequested = 0;
+
+static void requestStop(int)
+{
+    stopRequested = 1;
+}
+
+static pid_t startWorker(int serverFd, const CompileServerOptions &options, llvm::function_ref<void()> initWorker,
+                         llvm::function_ref<int(llvm::ArrayRef<std::string>)> handler)
+{
+    flushOutput();
+
+    auto pid = fork();
+    if (pid < 0)
+    {
+        llvm::errs() << "Can't start compile server worker: " << strerror(errno) << "\n";
+        return pid;
+    }
+
+    if (pid == 0)
+    {
+        // the server stops the worker by SIGTERM
+        signal(SIGTERM, SIG_DFL);
+        signal(SIGINT, SIG_DFL);
+
+        auto result = runWorker(serverFd, options, initWorker, handler);
+        flushOutput();
+        _exit(result);
+    }
+
+    return pid;
+}
+
+int runCompileServer(llvm::StringRef socketPath, const CompileServerOptions &options, llvm::function_ref<void()> initWorker,
+                     llvm::function_ref<int(llvm::ArrayRef<std::string>)> handler)
+{
+    auto isDefaultSocket = socketPath.empty();
+    auto serverSocketPath = isDefaultSocket ? getDefaultSocketPath() : socketPath.str();
+    if (isDefaultSocket && !checkSocketFolder(serverSocketPath, /*create=*/true))
+    {
+        return -1;
+    }
+
+    sockaddr_un addr;
+    if (!initAddress(serverSocketPath, addr))
+    {
+        return -1;
+    }
+
+    auto serverFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (serverFd < 0)
+    {
+        llvm::errs() << "Can't create socket: " << strerror(errno) << "\n";
+        return -1;
+    }
+
+    auto bound = bind(serverFd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0;
+    // only the socket left by the previous run in the folder of the user is removed, a path given by --socket is never
+    // removed before binding
+    if (!bound && errno == EADDRINUSE && isDefaultSocket && isStaleSocket(addr))
+    {
+        unlink(addr.sun_path);
+        bound = bind(serverFd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0;
+    }
+
+    if (!bound || listen(serverFd, SOMAXCONN))
+    {
+        llvm::errs() << "Can't listen on socket " << serverSocketPath << ": " << strerror(errno) << "\n";
+        close(serverFd);
+        return -1;
+    }
+
+    llvm::outs() << "Compile server is listening on " << serverSocketPath << "\n";
+    llvm::outs().flush();
+
+    // a client which is gone must not kill the worker writing the result to it
+    signal(SIGPIPE, SIG_IGN);
+
+    // without SA_RESTART wait is interrupted by the signal
+    struct sigaction stopAction = {};
+    stopAction.sa_handler = requestStop;
+    sigemptyset(&stopAction.sa_mask);
+    sigaction(SIGTERM, &stopAction, nullptr);
+    sigaction(SIGINT, &stopAction, nullptr);
+
+    std::set<pid_t> workers;
+    auto failed = false;
+    for (unsigned i = 0; i < std::max(options.workers, 1u) && !failed; i++)
+    {
+        auto pid = startWorker(serverFd, options, initWorker, handler);
+        failed = pid < 0;
+        if (!failed)
+        {
+            workers.insert(pid);
+        }
+    }
+
+    while (!failed && !workers.empty() && !stopRequested)
+    {
+        int status;
+        auto pid = wait(&status);
+        if (pid < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            llvm::errs() << "Can't wait for compile server workers: " << strerror(errno) << "\n";
+            break;
+        }
+
+        // workers of a server being stopped are not replaced (SIGINT of the terminal stops them as well)
+        if (!workers.erase(pid) || stopRequested)
+        {
+            continue;
+        }
+
+        // the worker can't accept connections, a new one won't either
+        if (WIFEXITED(status) && WEXITSTATUS(status))
+        {
+            break;
+        }
+
+        if (WIFSIGNALED(status))
+        {
+            llvm::errs() << "Compile server worker " << pid << " is terminated by signal " << WTERMSIG(status) << "\n";
+        }
+
+        // the worker is replaced (after maxRequests/maxMemory) or crashed
+        auto newPid = startWorker(serverFd, options, initWorker, handler);
+        failed = newPid < 0;
+        if (!failed)
+        {
+            workers.insert(newPid);
+        }
+    }
+
+    for (auto pid : workers)
+    {
+        kill(pid, SIGTERM);
+        waitpid(pid, nullptr, 0);
+    }
+
+    close(serverFd);
+    unlink(addr.sun_path);
+    return stopRequested ? 0 : -1;
+}
+
+int runInChildProcess(llvm::function_ref<int()> action)
+{
+    flushOutput();
+
+    auto pid = fork();
+    if (pid < 0)
+    {
+        llvm::errs() << "Can't start child process: " << strerror(errno) << "\n";
+        return -1;
+    }
+
+    if (pid == 0)
+    {
+        signal(SIGPIPE, SIG_DFL);
+
+        auto result = action();
+        flushOutput();
+        _exit(result);
+    }
+
+    int status;
+    while (waitpid(pid, &status, 0) < 0)
+    {
+        if (errno != EINTR)
+        {
+            llvm::errs() << "Can't wait for child process: " << strerror(errno) << "\n";
+            return -1;
+        }
+    }
+
+    if (WIFSIGNALED(status))
+    {
+        llvm::errs() << "Child process is terminated by signal " << WTERMSIG(status) << "\n";
+        return -1;
+    }
+
+    // the exit code has 8 bits, -1 comes back as -1
+    return static_cast<int8_t>(WEXITSTATUS(status));
+}
+
+int runCompileServerClient(llvm::StringRef socketPath, llvm::ArrayRef<std::string> args)
+{
+    auto isDefaultSocket = socketPath.empty();
+    auto serverSocketPath = isDefaultSocket ? getDefaultSocketPath() : socketPath.str();
+    if (isDefaultSocket && !checkSocketFolder(serverSocketPath, /*create=*/false))
+    {
+        return -1;
+    }
+
+    sockaddr_un addr;
+    if (!initAddress(serverSocketPath, addr))
+    {
+        return -1;
+    }
+
+    auto fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)))
+    {
+        llvm::errs() << "Can't connect to compile server " << serverSocketPath << ": " << strerror(errno) << "\n";
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+
+        return -1;
+    }
+
+    // the command line and the output handles are not sent to the server of another user
+    if (!isPeerOfSameUser(fd))
+    {
+        llvm::errs() << "Compile server " << serverSocketPath << " is run by another user\n";
+        close(fd);
+        return -1;
+    }
+
+    llvm::SmallString<256> workingDir;
+    llvm::sys::fs::current_path(workingDir);
+
+    std::string payload;
+    payload.append(workingDir.begin(), workingDir.end());
+    payload.push_back('\0');
+    for (auto &arg : args)
+    {
+        payload.append(arg);
+        payload.push_back('\0');
+    }
+
+    uint32_t payloadSize = payload.size();
+    iovec iov{&payloadSize, sizeof(payloadSize)};
+
+    int fds[3] = {STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO};
+    char control[CMSG_SPACE(sizeof(fds))];
+    memset(control, 0, sizeof(control));
+
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    auto cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+    int32_t result = -1;
+    if (sendmsg(fd, &msg, 0) != sizeof(payloadSize) || !writeAll(fd, payload.data(), payload.size()) ||
+        !readAll(fd, &result, sizeof(result)))
+    {
+        llvm::errs() << "Compile server connection failed\n";
+        result = -1;
+    }
+
+    close(fd);
+    return result;
+}
+
+#endif
+
+} // namespace typescript
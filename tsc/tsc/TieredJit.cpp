@@ -0,0 +1,362 @@
+#include "TypeScript/TieredJit.h"
+
+#include "llvm/ADT/Sequence.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/ExecutionEngine/Orc/CompileUtils.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/MDBuilder.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/BasicBlockUtils.h"
+
+#define DEBUG_TYPE "tsc"
+
+#define TIER0_SUFFIX "$tier0"
+#define TIER2_SUFFIX "$tier2"
+#define TIER2_MODULE_PREFIX "tier2:"
+#define TIER_UP_FUNCTION "__tsc_jit_tier_up"
+
+namespace typescript
+{
+
+namespace
+{
+
+// tier 0 is compiled without optimizations for fast start, tier 2 with all of them
+class TieredCompiler : public llvm::orc::IRCompileLayer::IRCompiler
+{
+  public:
+    TieredCompiler(std::unique_ptr<llvm::TargetMachine> tier0TargetMachine, std::unique_ptr<llvm::TargetMachine> tier2TargetMachine)
+        : IRCompiler(llvm::orc::irManglingOptionsFromTargetOptions(tier0TargetMachine->Options)),
+          tier0TargetMachine(std::move(tier0TargetMachine)), tier2TargetMachine(std::move(tier2TargetMachine))
+    {
+    }
+
+    llvm::Expected<std::unique_ptr<llvm::MemoryBuffer>> operator()(llvm::Module &module) override
+    {
+        auto isTier2 = llvm::StringRef(module.getModuleIdentifier()).startswith(TIER2_MODULE_PREFIX);
+        return llvm::orc::SimpleCompiler(isTier2 ? *tier2TargetMachine : *tier0TargetMachine)(module);
+    }
+
+  private:
+    std::unique_ptr<llvm::TargetMachine> tier0TargetMachine;
+    std::unique_ptr<llvm::TargetMachine> tier2TargetMachine;
+};
+
+// renames the definition and leaves declaration with the original name for all uses, so calls go through the stub
+void redirectToStub(llvm::Function &function, llvm::StringRef suffix)
+{
+    auto name = function.getName().str();
+    function.setName(name + suffix);
+
+    auto declaration = llvm::Function::Create(function.getFunctionType(), llvm::GlobalValue::ExternalLinkage, name,
+                                              function.getParent());
+    declaration->setCallingConv(function.getCallingConv());
+    declaration->setAttributes(function.getAttributes());
+    function.replaceAllUsesWith(declaration);
+}
+
+} // namespace
+
+llvm::Expected<std::unique_ptr<TieredJit>> TieredJit::create(unsigned threshold, TransformerT tier0Transformer,
+                                                             TransformerT tier2Transformer)
+{
+    auto jtmbOrErr = llvm::orc::JITTargetMachineBuilder::detectHost();
+    if (!jtmbOrErr)
+    {
+        return jtmbOrErr.takeError();
+    }
+
+    auto compileFunctionCreator =
+        [](llvm::orc::JITTargetMachineBuilder jtmb) -> llvm::Expected<std::unique_ptr<llvm::orc::IRCompileLayer::IRCompiler>> {
+        auto tier0TargetMachineOrErr = jtmb.setCodeGenOptLevel(llvm::CodeGenOpt::None).createTargetMachine();
+        if (!tier0TargetMachineOrErr)
+        {
+            return tier0TargetMachineOrErr.takeError();
+        }
+
+        auto tier2TargetMachineOrErr = jtmb.setCodeGenOptLevel(llvm::CodeGenOpt::Aggressive).createTargetMachine();
+        if (!tier2TargetMachineOrErr)
+        {
+            return tier2TargetMachineOrErr.takeError();
+        }
+
+        return std::make_unique<TieredCompiler>(std::move(*tier0TargetMachineOrErr), std::move(*tier2TargetMachineOrErr));
+    };
+
+    std::unique_ptr<TieredJit> tieredJit(new TieredJit(threshold, std::move(tier0Transformer), std::move(tier2Transformer)));
+
+    auto triple = jtmbOrErr->getTargetTriple();
+    auto jitOrErr =
+        llvm::orc::LLJITBuilder().setJITTargetMachineBuilder(std::move(*jtmbOrErr)).setCompileFunctionCreator(compileFunctionCreator).create();
+    if (!jitOrErr)
+    {
+        return jitOrErr.takeError();
+    }
+
+    tieredJit->jit = std::move(*jitOrErr);
+    tieredJit->stubsManager = llvm::orc::createLocalIndirectStubsManagerBuilder(triple)();
+    if (!tieredJit->stubsManager)
+    {
+        return llvm::make_error<llvm::StringError>("indirect stubs are not supported for " + triple.str(),
+                                                   llvm::inconvertibleErrorCode());
+    }
+
+    return std::move(tieredJit);
+}
+
+TieredJit::TieredJit(unsigned threshold, TransformerT tier0Transformer, TransformerT tier2Transformer)
+    : threshold(threshold), tier0Transformer(std::move(tier0Transformer)), tier2Transformer(std::move(tier2Transformer)),
+      backgroundCompilation(std::make_unique<llvm::ThreadPool>(llvm::hardware_concurrency(1)))
+{
+}
+
+TieredJit::~TieredJit()
+{
+    backgroundCompilation->wait();
+}
+
+llvm::Error TieredJit::addModule(llvm::orc::ThreadSafeModule threadSafeModule)
+{
+    if (auto error = threadSafeModule.withModuleDo([&](llvm::Module &module) { return prepareModule(module); }))
+    {
+        return error;
+    }
+
+    // calls of all functions go through stubs, they point to tier 0 code first
+    llvm::orc::IndirectStubsManager::StubInitsMap stubInits;
+    for (auto &name : functionNames)
+    {
+        stubInits[name] = {0, llvm::JITSymbolFlags::Exported | llvm::JITSymbolFlags::Callable};
+    }
+
+    if (auto error = stubsManager->createStubs(stubInits))
+    {
+        return error;
+    }
+
+    llvm::orc::MangleAndInterner mangle(jit->getExecutionSession(), jit->getDataLayout());
+    llvm::orc::SymbolMap symbols;
+    for (auto &name : functionNames)
+    {
+        symbols[mangle(name)] = stubsManager->findStub(name, /*ExportedStubsOnly=*/false);
+    }
+
+    symbols[mangle(TIER_UP_FUNCTION)] = llvm::JITEvaluatedSymbol::fromPointer(&TieredJit::tierUp);
+
+    if (auto error = jit->getMainJITDylib().define(llvm::orc::absoluteSymbols(symbols)))
+    {
+        return error;
+    }
+
+    if (auto error = jit->addIRModule(std::move(threadSafeModule)))
+    {
+        return error;
+    }
+
+    for (auto &name : functionNames)
+    {
+        auto symbolOrErr = jit->lookup(name + TIER0_SUFFIX);
+        if (!symbolOrErr)
+        {
+            return symbolOrErr.takeError();
+        }
+
+        if (auto error = stubsManager->updatePointer(name, symbolOrErr->getAddress()))
+        {
+            return error;
+        }
+    }
+
+    return llvm::Error::success();
+}
+
+llvm::Error TieredJit::prepareModule(llvm::Module &module)
+{
+    module.setDataLayout(jit->getDataLayout());
+    module.setTargetTriple(jit->getTargetTriple().str());
+
+    // tier 2 module refers to everything defined in this module
+    for (auto &globalValue : module.global_values())
+    {
+        if (globalValue.isDeclaration() || globalValue.getName().startswith("llvm."))
+        {
+            continue;
+        }
+
+        if (!globalValue.hasName())
+        {
+            globalValue.setName("__tsc_tiered");
+        }
+
+        if (globalValue.hasLocalLinkage())
+        {
+            globalValue.setLinkage(llvm::GlobalValue::ExternalLinkage);
+            globalValue.setVisibility(llvm::GlobalValue::HiddenVisibility);
+        }
+    }
+
+    for (auto &function : module)
+    {
+        if (!function.isDeclaration())
+        {
+            functionNames.push_back(function.getName().str());
+        }
+    }
+
+    llvm::raw_svector_ostream os(moduleBitcode);
+    llvm::WriteBitcodeToFile(module, os);
+
+    for (auto index : llvm::seq<unsigned>(0, functionNames.size()))
+    {
+        auto function = module.getFunction(functionNames[index]);
+        redirectToStub(*function, TIER0_SUFFIX);
+        instrumentFunction(*function, index);
+    }
+
+    return tier0Transformer(&module);
+}
+
+void TieredJit::instrumentFunction(llvm::Function &function, unsigned index)
+{
+    auto &context = function.getContext();
+    auto module = function.getParent();
+    auto int64Type = llvm::Type::getInt64Ty(context);
+    auto int8PtrType = llvm::Type::getInt8PtrTy(context);
+
+    auto counter = new llvm::GlobalVariable(*module, int64Type, /*isConstant=*/false, llvm::GlobalValue::PrivateLinkage,
+                                            llvm::ConstantInt::get(int64Type, 0), function.getName() + ".counter");
+    auto tierUpFunction = module->getOrInsertFunction(
+        TIER_UP_FUNCTION, llvm::FunctionType::get(llvm::Type::getVoidTy(context), {int8PtrType, int64Type}, false));
+
+    // after allocas, they have to stay in the entry block
+    auto &entryBlock = function.getEntryBlock();
+    auto insertPoint = entryBlock.getFirstInsertionPt();
+    while (llvm::isa<llvm::AllocaInst>(*insertPoint))
+    {
+        ++insertPoint;
+    }
+
+    llvm::IRBuilder<> builder(&*insertPoint);
+    auto count = builder.CreateAtomicRMW(llvm::AtomicRMWInst::Add, counter, llvm::ConstantInt::get(int64Type, 1),
+                                         llvm::MaybeAlign(8), llvm::AtomicOrdering::Monotonic);
+    auto isHot = builder.CreateICmpEQ(count, llvm::ConstantInt::get(int64Type, threshold - 1));
+
+    auto tierUpTerminator = llvm::SplitBlockAndInsertIfThen(isHot, &*insertPoint, /*Unreachable=*/false,
+                                                            llvm::MDBuilder(context).createBranchWeights(1, threshold));
+    builder.SetInsertPoint(tierUpTerminator);
+    auto self = llvm::ConstantExpr::getIntToPtr(llvm::ConstantInt::get(int64Type, reinterpret_cast<uintptr_t>(this)), int8PtrType);
+    builder.CreateCall(tierUpFunction, {self, llvm::ConstantInt::get(int64Type, index)});
+}
+
+void TieredJit::tierUp(TieredJit *tieredJit, int64_t index)
+{
+    tieredJit->backgroundCompilation->async([tieredJit, index]() { tieredJit->recompile(index); });
+}
+
+void TieredJit::recompile(unsigned index)
+{
+    auto &name = functionNames[index];
+
+    auto reportError = [&](llvm::Error error) {
+        // function just stays in tier 0
+        llvm::handleAllErrors(std::move(error), [&](const llvm::ErrorInfoBase &info) {
+            LLVM_DEBUG(llvm::dbgs() << "tier 2 compilation of " << name << " failed: " << info.message() << "\n";);
+        });
+    };
+
+    auto context = std::make_unique<llvm::LLVMContext>();
+    auto moduleOrErr = llvm::parseBitcodeFile(
+        llvm::MemoryBufferRef(llvm::StringRef(moduleBitcode.data(), moduleBitcode.size()), name), *context);
+    if (!moduleOrErr)
+    {
+        reportError(moduleOrErr.takeError());
+        return;
+    }
+
+    auto module = std::move(*moduleOrErr);
+    if (!module->alias_empty() || !module->ifunc_empty())
+    {
+        LLVM_DEBUG(llvm::dbgs() << "tier 2 compilation of " << name << " skipped: module has aliases\n";);
+        return;
+    }
+
+    // only the hot function is defined, other functions are kept for inlining
+    for (auto &function : *module)
+    {
+        if (!function.isDeclaration() && function.getName() != name)
+        {
+            function.setLinkage(llvm::GlobalValue::AvailableExternallyLinkage);
+            function.setVisibility(llvm::GlobalValue::DefaultVisibility);
+            function.setComdat(nullptr);
+        }
+    }
+
+    for (auto it = module->global_begin(); it != module->global_end();)
+    {
+        auto &global = *it++;
+        if (global.getName().startswith("llvm."))
+        {
+            // constructors are already run by tier 0
+            if (global.use_empty())
+            {
+                global.eraseFromParent();
+            }
+
+            continue;
+        }
+
+        if (global.isDeclaration())
+        {
+            continue;
+        }
+
+        global.setComdat(nullptr);
+        if (global.isConstant())
+        {
+            global.setLinkage(llvm::GlobalValue::AvailableExternallyLinkage);
+            global.setVisibility(llvm::GlobalValue::DefaultVisibility);
+        }
+        else
+        {
+            global.setInitializer(nullptr);
+            global.setLinkage(llvm::GlobalValue::ExternalLinkage);
+        }
+    }
+
+    redirectToStub(*module->getFunction(name), TIER2_SUFFIX);
+    module->setModuleIdentifier(TIER2_MODULE_PREFIX + name);
+
+    if (auto error = tier2Transformer(module.get()))
+    {
+        reportError(std::move(error));
+        return;
+    }
+
+    if (auto error = jit->addIRModule(llvm::orc::ThreadSafeModule(std::move(module), std::move(context))))
+    {
+        reportError(std::move(error));
+        return;
+    }
+
+    auto symbolOrErr = jit->lookup(name + TIER2_SUFFIX);
+    if (!symbolOrErr)
+    {
+        reportError(symbolOrErr.takeError());
+        return;
+    }
+
+    if (auto error = stubsManager->updatePointer(name, symbolOrErr->getAddress()))
+    {
+        reportError(std::move(error));
+        return;
+    }
+
+    LLVM_DEBUG(llvm::dbgs() << "tier 2: " << name << "\n";);
+
+    tier2Count++;
+}
+
+} // namespace typescript
@@ -0,0 +1,199 @@
+#include "TypeScript/TimeReport.h"
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/Timer.h"
+
+#include <functional>
+
+#ifdef WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace typescript
+{
+
+size_t getPeakRSS()
+{
+#ifdef WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        return counters.PeakWorkingSetSize;
+    }
+
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage))
+    {
+        return 0;
+    }
+
+#ifdef __APPLE__
+    return usage.ru_maxrss;
+#else
+    return usage.ru_maxrss * 1024;
+#endif
+#endif
+}
+
+struct TimeReportManager::TimerNode
+{
+    TimerNode(std::string name) : name(std::move(name))
+    {
+    }
+
+    std::string name;
+    llvm::TimeRecord total;
+    size_t peakRSS = 0;
+    size_t peakRSSDelta = 0;
+    unsigned count = 0;
+
+    // the same timer can be started in several threads (passes running on functions in parallel)
+    llvm::DenseMap<uint64_t, std::pair<llvm::TimeRecord, size_t>> running;
+
+    llvm::MapVector<const void *, std::unique_ptr<TimerNode>> children;
+};
+
+TimeReportManager::TimeReportManager() : root(std::make_unique<TimerNode>("Total"))
+{
+    startTimer(root.get());
+}
+
+TimeReportManager::~TimeReportManager() = default;
+
+llvm::Optional<void *> TimeReportManager::rootTimer()
+{
+    return root.get();
+}
+
+void TimeReportManager::startTimer(void *handle)
+{
+    auto record = llvm::TimeRecord::getCurrentTime(/*Start=*/true);
+    auto peakRSS = getPeakRSS();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto node = static_cast<TimerNode *>(handle);
+    node->running[llvm::get_threadid()] = {record, peakRSS};
+}
+
+void TimeReportManager::stopTimer(void *handle)
+{
+    auto record = llvm::TimeRecord::getCurrentTime(/*Start=*/false);
+    auto peakRSS = getPeakRSS();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto node = static_cast<TimerNode *>(handle);
+    auto it = node->running.find(llvm::get_threadid());
+    if (it == node->running.end())
+    {
+        return;
+    }
+
+    record -= it->second.first;
+    node->total += record;
+    node->count++;
+    node->peakRSS = std::max(node->peakRSS, peakRSS);
+    node->peakRSSDelta = std::max(node->peakRSSDelta, peakRSS - it->second.second);
+    node->running.erase(it);
+}
+
+void *TimeReportManager::nestTimer(void *handle, const void *id, llvm::function_ref<std::string()> nameBuilder)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto node = static_cast<TimerNode *>(handle);
+    auto &child = node->children[id];
+    if (!child)
+    {
+        child = std::make_unique<TimerNode>(nameBuilder());
+    }
+
+    return child.get();
+}
+
+static double toMB(size_t bytes)
+{
+    return bytes / (1024.0 * 1024.0);
+}
+
+void TimeReportManager::print(llvm::raw_ostream &os, TimeReportFormat format)
+{
+    if (!root->running.empty())
+    {
+        // root is started on current thread in constructor
+        stopTimer(root.get());
+    }
+
+    std::function<void(TimerNode *, unsigned)> printNode;
+    std::function<void(llvm::json::OStream &, TimerNode *)> printJsonNode;
+
+    switch (format)
+    {
+    case TimeReportFormat::Text:
+        os << "===" << std::string(73, '-') << "===\n";
+        os.indent(26) << "TypeScript compiler time report\n";
+        os << "===" << std::string(73, '-') << "===\n";
+        os << "   Wall (s)    User (s)  System (s)  Peak RSS (MB)  RSS Growth (MB)  Name\n";
+
+        printNode = [&](TimerNode *node, unsigned indent) {
+            os << llvm::format("%11.4f %11.4f %11.4f %14.1f %16.1f  ", node->total.getWallTime(), node->total.getUserTime(),
+                               node->total.getSystemTime(), toMB(node->peakRSS), toMB(node->peakRSSDelta));
+            os.indent(indent) << node->name;
+            if (node->count > 1)
+            {
+                os << " (" << node->count << ")";
+            }
+
+            os << "\n";
+
+            for (auto &child : node->children)
+            {
+                printNode(child.second.get(), indent + 2);
+            }
+        };
+
+        printNode(root.get(), 0);
+        break;
+
+    case TimeReportFormat::Json: {
+        llvm::json::OStream json(os, 2);
+
+        printJsonNode = [&](llvm::json::OStream &json, TimerNode *node) {
+            json.object([&]() {
+                json.attribute("name", node->name);
+                json.attribute("wall", node->total.getWallTime());
+                json.attribute("user", node->total.getUserTime());
+                json.attribute("system", node->total.getSystemTime());
+                json.attribute("peakRSS", static_cast<int64_t>(node->peakRSS));
+                json.attribute("peakRSSGrowth", static_cast<int64_t>(node->peakRSSDelta));
+                json.attribute("count", static_cast<int64_t>(node->count));
+                if (!node->children.empty())
+                {
+                    json.attributeArray("children", [&]() {
+                        for (auto &child : node->children)
+                        {
+                            printJsonNode(json, child.second.get());
+                        }
+                    });
+                }
+            });
+        };
+
+        printJsonNode(json, root.get());
+        os << "\n";
+        break;
+    }
+    }
+
+    os.flush();
+}
+
+} // namespace typescript
@@ -1,4 +1,6 @@
 #include "TypeScript/Config.h"
+#include "TypeScript/CompileCache.h"
+#include "TypeScript/CompileServer.h"
 #include "TypeScript/Defines.h"
 #include "TypeScript/MLIRGen.h"
 #include "TypeScript/Passes.h"
@@ -7,6 +9,8 @@
 #include "TypeScript/TypeScriptOps.h"
 #include "TypeScript/TypeScriptDialectTranslation.h"
 #include "TypeScript/TypeScriptGC.h"
+#include "TypeScript/TieredJit.h"
+#include "TypeScript/TimeReport.h"
 #ifdef ENABLE_ASYNC
 #include "TypeScript/AsyncDialectTranslation.h"
 #endif
@@ -19,6 +23,7 @@
 
 #include "TypeScript/rt.h"
 
+#include "mlir/Dialect/LLVMIR/LLVMDialect.h"
 #include "mlir/ExecutionEngine/ExecutionEngine.h"
 #include "mlir/ExecutionEngine/OptUtils.h"
 #include "mlir/IR/AsmState.h"
@@ -50,16 +55,46 @@
 #endif
 
 #include "llvm/PassInfo.h"
+#include "llvm/ADT/Sequence.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/ADT/Triple.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/ExecutionEngine/Orc/CompileUtils.h"
+#include "llvm/ExecutionEngine/Orc/ExecutionUtils.h"
+#include "llvm/ExecutionEngine/Orc/LLJIT.h"
+#include "llvm/ExecutionEngine/Orc/RTDyldObjectLinkingLayer.h"
+#include "llvm/ExecutionEngine/Orc/ThreadSafeModule.h"
+#include "llvm/ExecutionEngine/SectionMemoryManager.h"
+#include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Module.h"
+#include "llvm/MC/SubtargetFeature.h"
+#include "llvm/MC/TargetRegistry.h"
+#include "llvm/Object/ObjectFile.h"
+#include "llvm/ProfileData/InstrProf.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/ErrorOr.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/MD5.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Program.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/FormatVariadic.h"
+#include "llvm/Target/TargetMachine.h"
+#include "llvm/Target/TargetOptions.h"
+#include "llvm/Transforms/Utils/SplitModule.h"
 
 // for custom pass
 #include "llvm/IR/PassManager.h"
@@ -83,7 +118,7 @@
 using namespace typescript;
 namespace cl = llvm::cl;
 
-static cl::opt<std::string> inputFilename(cl::Positional, cl::desc("<input TypeScript file>"), cl::init("-"), cl::value_desc("filename"));
+static cl::list<std::string> inputFilenames(cl::Positional, cl::desc("<input TypeScript files>"), cl::ZeroOrMore, cl::value_desc("filenames"));
 
 namespace
 {
@@ -108,7 +143,9 @@ enum Action
     DumpMLIRAffine,
     DumpMLIRLLVM,
     DumpLLVMIR,
-    RunJIT
+    RunJIT,
+    DumpObj,
+    BuildExe
 };
 } // namespace
 
@@ -118,7 +155,9 @@ static cl::opt<enum Action> emitAction("emit", cl::desc("Select the kind of outp
                                        cl::values(clEnumValN(DumpMLIRAffine, "mlir-affine", "output the MLIR dump after affine lowering")),
                                        cl::values(clEnumValN(DumpMLIRLLVM, "mlir-llvm", "output the MLIR dump after llvm lowering")),
                                        cl::values(clEnumValN(DumpLLVMIR, "llvm", "output the LLVM IR dump")),
-                                       cl::values(clEnumValN(RunJIT, "jit", "JIT the code and run it by invoking the main function")));
+                                       cl::values(clEnumValN(RunJIT, "jit", "JIT the code and run it by invoking the main function")),
+                                       cl::values(clEnumValN(DumpObj, "obj", "compile the code into native object file")),
+                                       cl::values(clEnumValN(BuildExe, "exe", "compile the code into native object file and link it into executable")));
 
 static cl::opt<bool> enableOpt{"opt", cl::desc("Enable optimizations"), cl::init(false)};
 
@@ -135,14 +174,107 @@ static cl::opt<std::string> mainFuncName{"e", cl::desc("The function to be calle
 static cl::opt<bool> dumpObjectFile{"dump-object-file", cl::desc("Dump JITted-compiled object to file specified with "
                                                                  "-object-filename (<input file>.o by default).")};
 
+static cl::opt<bool> jitLazy{"jit-lazy", cl::desc("Compile each function on its first call instead of the whole module before "
+                                                 "running (-emit=jit only)")};
+
+static cl::opt<bool> jitTiered{"jit-tiered", cl::desc("Compile functions without optimizations first and recompile hot functions with "
+                                                     "-O3 in background (-emit=jit only)")};
+static cl::opt<unsigned> jitTierThreshold{"jit-tier-threshold", cl::desc("Number of calls after which function is recompiled with -O3"),
+                                          cl::value_desc("N"), cl::init(1000)};
+
+static cl::opt<bool> profileGenerate{"profile-generate",
+                                     cl::desc("Instrument code to write raw profile at exit (to LLVM_PROFILE_FILE, default.profraw by "
+                                              "default), executable is linked with clang_rt.profile of compiler-rt, JIT needs "
+                                              "TypeScriptRuntime shared library")};
+static cl::opt<std::string> profileUse{"profile-use", cl::desc("Optimize code with profile merged by llvm-profdata"),
+                                       cl::value_desc("filename")};
+
 static cl::opt<std::string> objectFilename{"object-filename", cl::desc("Dump JITted-compiled object to file <input file>.o")};
 
+static cl::opt<std::string> cacheDir{"cache-dir",
+                                     cl::desc("Folder of the compilation cache, cached LLVM bitcode (-emit=llvm) or object file "
+                                              "(-emit=obj, -emit=exe) is used when the source, includes and options are not changed, "
+                                              "object files of JIT-ed modules (-emit=jit) are reused when LLVM IR is not changed"),
+                                     cl::value_desc("directory")};
+
+static cl::opt<unsigned> cacheSizeLimit{"cache-size-limit",
+                                        cl::desc("Maximum size of the compilation cache in MB, least recently used entries are "
+                                                 "removed (0 - no limit)"),
+                                        cl::value_desc("MB"), cl::init(1024)};
+
+static cl::opt<unsigned> codeGenThreads{"codegen-threads",
+                                         cl::desc("Split module into N partitions to optimize and emit them in parallel "
+                                                  "(-emit=obj and -emit=exe only, on Windows -emit=exe without --cache-dir only)"),
+                                         cl::value_desc("N"), cl::init(1)};
+
+static cl::opt<bool> parallelLowering{"parallel-lowering",
+                                      cl::desc("Lower bodies of functions to LLVM dialect in parallel (on all hardware threads "
+                                               "when one input file is compiled)")};
+
+static cl::opt<unsigned> jobs{"jobs",
+                               cl::desc("Number of input files compiled in parallel (all hardware threads by default, "
+                                        "-emit=obj and -emit=exe only)"),
+                               cl::value_desc("N"), cl::init(0)};
+
+static cl::opt<std::string> outputFilename{"o", cl::desc("Output filename for -emit=obj and -emit=exe"), cl::value_desc("filename"),
+                                           cl::init("")};
+
+// link exe
+static cl::opt<std::string> linkerName{"linker", cl::desc("Linker to build executable (gcc by default, lld-link on Windows)"),
+                                       cl::value_desc("linker"), cl::cat(clOptionsCategory)};
+static cl::list<std::string> clLibPaths{"L", cl::desc("Library search path to use when building executable"), cl::Prefix, cl::ZeroOrMore,
+                                        cl::cat(clOptionsCategory)};
+static cl::list<std::string> clLibs{"l", cl::desc("Library to link when building executable"), cl::Prefix, cl::ZeroOrMore,
+                                    cl::cat(clOptionsCategory)};
+
 // static cl::opt<std::string> targetTriple("mtriple", cl::desc("Override target triple for module"));
 
+namespace
+{
+enum TimeReport
+{
+    NoTimeReport,
+    TextTimeReport,
+    JsonTimeReport
+};
+} // namespace
+
+static cl::opt<enum TimeReport> timeReport("time-report", cl::desc("Report wall time, CPU time and peak RSS of each compilation phase"),
+                                           cl::ValueOptional, cl::init(NoTimeReport),
+                                           cl::values(clEnumValN(TextTimeReport, "", "report as text")),
+                                           cl::values(clEnumValN(TextTimeReport, "text", "report as text")),
+                                           cl::values(clEnumValN(JsonTimeReport, "json", "report as JSON")));
+
+static cl::opt<std::string> timeReportFilename{"time-report-file", cl::desc("Write time report to file instead of stderr"),
+                                               cl::value_desc("filename")};
+
+static cl::opt<bool> serve{"serve", cl::desc("Run as compile server: keep compiler warm and compile requests sent with --connect")};
+static cl::opt<bool> connectToServer{"connect", cl::desc("Send compilation to the compile server started with --serve")};
+static cl::opt<std::string> socketPath{"socket", cl::desc("Socket of the compile server (tsc-server.sock in $XDG_RUNTIME_DIR or in tsc-<uid> "
+                                                                    "folder in temp folder by default)"),
+                                       cl::value_desc("path")};
+static cl::opt<unsigned> serverWorkers{"server-workers",
+                                       cl::desc("Number of requests the compile server runs at the same time, each one in a worker "
+                                                "process with its own warm context (all hardware threads by default)"),
+                                       cl::value_desc("N"), cl::init(0)};
+static cl::opt<unsigned> serverMaxRequests{"server-max-requests",
+                                           cl::desc("Replace a worker of the compile server by a new one after N requests "
+                                                    "(100 by default, 0 - never)"),
+                                           cl::value_desc("N"), cl::init(100)};
+static cl::opt<unsigned> serverMaxMemory{"server-max-memory",
+                                         cl::desc("Replace a worker of the compile server by a new one when its heap is larger "
+                                                  "than N MB after a request (1024 by default, 0 - never)"),
+                                         cl::value_desc("MB"), cl::init(1024)};
+
+// warm state of the worker of the compile server
+static mlir::MLIRContext *serverContext;
+static std::shared_ptr<IncludeFilesCache> serverIncludeFilesCache;
+
 cl::OptionCategory clTsCompilingOptionsCategory{"TypeScript compiling options"};
 static cl::opt<bool> disableGC("nogc", cl::desc("Disable Garbage collection"), cl::cat(clTsCompilingOptionsCategory));
 
-int loadMLIR(mlir::MLIRContext &context, mlir::OwningOpRef<mlir::ModuleOp> &module)
+int loadMLIR(mlir::MLIRContext &context, llvm::StringRef inputFilename, mlir::OwningOpRef<mlir::ModuleOp> &module,
+             mlir::TimingScope &timing, std::vector<std::string> *dependencies, std::vector<std::string> *importedModules)
 {
     auto fileName = llvm::StringRef(inputFilename);
 
@@ -158,7 +290,13 @@ int loadMLIR(mlir::MLIRContext &context, mlir::OwningOpRef<mlir::ModuleOp> &modu
 
         CompileOptions compileOptions;
         compileOptions.disableGC = disableGC;
-        module = mlirGenFromSource(context, fileName, fileOrErr.get()->getBuffer(), compileOptions);
+        // parsed include files can't be shared between compilations running in parallel
+        if (inputFilenames.size() <= 1)
+        {
+            compileOptions.includeFilesCache = serverIncludeFilesCache;
+        }
+
+        module = mlirGenFromSource(context, fileName, fileOrErr.get()->getBuffer(), compileOptions, dependencies, importedModules, &timing);
         return !module ? 1 : 0;
     }
 
@@ -171,6 +309,7 @@ int loadMLIR(mlir::MLIRContext &context, mlir::OwningOpRef<mlir::ModuleOp> &modu
     }
 
     // Parse the input mlir.
+    auto parsingTiming = timing.nest("Parsing");
     llvm::SourceMgr sourceMgr;
     sourceMgr.AddNewSourceBuffer(std::move(*fileOrErr), llvm::SMLoc());
     module = mlir::parseSourceFile<mlir::ModuleOp>(sourceMgr, &context);
@@ -183,9 +322,11 @@ int loadMLIR(mlir::MLIRContext &context, mlir::OwningOpRef<mlir::ModuleOp> &modu
     return 0;
 }
 
-int loadAndProcessMLIR(mlir::MLIRContext &context, mlir::OwningOpRef<mlir::ModuleOp>  &module)
+int loadAndProcessMLIR(mlir::MLIRContext &context, llvm::StringRef inputFilename, mlir::OwningOpRef<mlir::ModuleOp> &module,
+                       mlir::TimingScope &timing, std::vector<std::string> *dependencies = nullptr,
+                       std::vector<std::string> *importedModules = nullptr)
 {
-    if (int error = loadMLIR(context, module))
+    if (int error = loadMLIR(context, inputFilename, module, timing, dependencies, importedModules))
     {
         return error;
     }
@@ -262,13 +403,16 @@ int loadAndProcessMLIR(mlir::MLIRContext &context, mlir::OwningOpRef<mlir::Modul
 #ifdef ENABLE_ASYNC
         pm.addPass(mlir::createConvertAsyncToLLVMPass());
 #endif
-        pm.addPass(mlir::typescript::createLowerToLLVMPass());
+        pm.addPass(mlir::typescript::createLowerToLLVMPass(parallelLowering, emitAction == Action::RunJIT));
         if (!disableGC)
         {
             pm.addPass(mlir::typescript::createGCPass());
         }
     }
 
+    auto pipelineTiming = timing.nest("MLIR Pipeline");
+    pm.enableTiming(pipelineTiming);
+
     auto result = 0;
     if (mlir::failed(pm.run(*module)))
     {
@@ -279,7 +423,7 @@ int loadAndProcessMLIR(mlir::MLIRContext &context, mlir::OwningOpRef<mlir::Modul
     return result;
 }
 
-int dumpAST()
+int dumpAST(llvm::StringRef inputFilename)
 {
     if (inputType == InputType::MLIR && !llvm::StringRef(inputFilename).endswith(".mlir"))
     {
@@ -299,6 +443,20 @@ int dumpAST()
     return 0;
 }
 
+void loadDialects(mlir::MLIRContext &context)
+{
+    // Load our Dialect in this MLIR Context.
+    context.getOrLoadDialect<mlir::typescript::TypeScriptDialect>();
+    context.getOrLoadDialect<mlir::arith::ArithmeticDialect>();
+    context.getOrLoadDialect<mlir::math::MathDialect>();
+    context.getOrLoadDialect<mlir::cf::ControlFlowDialect>();
+    context.getOrLoadDialect<mlir::func::FuncDialect>();
+    context.getOrLoadDialect<mlir::LLVM::LLVMDialect>();
+#ifdef ENABLE_ASYNC
+    context.getOrLoadDialect<mlir::async::AsyncDialect>();
+#endif
+}
+
 int initDialects(mlir::ModuleOp module)
 {
     // Register the translation to LLVM IR with the MLIR context.
@@ -345,15 +503,32 @@ static llvm::Optional<llvm::OptimizationLevel> mapToLevel(unsigned optLevel, uns
     return llvm::None;
 }
 
+static llvm::Optional<llvm::PGOOptions> getPGOOptions()
+{
+    if (profileGenerate)
+    {
+        // no output file, profile runtime uses LLVM_PROFILE_FILE
+        return llvm::PGOOptions("", "", "", llvm::PGOOptions::IRInstr);
+    }
+
+    if (!profileUse.empty())
+    {
+        return llvm::PGOOptions(profileUse, "", "", llvm::PGOOptions::IRUse);
+    }
+
+    return llvm::None;
+}
+
 std::function<llvm::Error(llvm::Module *)> makeCustomPassesWithOptimizingTransformer(llvm::Optional<unsigned> mbOptLevel,
                                                                      llvm::TargetMachine *targetMachine)
 {
     return [mbOptLevel, targetMachine](llvm::Module *m) -> llvm::Error {
-        llvm::Optional<llvm::OptimizationLevel> ol = mapToLevel(optLevel, sizeLevel);
+        unsigned level = mbOptLevel ? *mbOptLevel : optLevel;
+        llvm::Optional<llvm::OptimizationLevel> ol = mapToLevel(level, sizeLevel);
         if (!ol)
         {
             return llvm::make_error<llvm::StringError>(
-                llvm::formatv("invalid optimization/size level {0}/{1}", optLevel, sizeLevel).str(),
+                llvm::formatv("invalid optimization/size level {0}/{1}", level, sizeLevel).str(),
                 llvm::inconvertibleErrorCode());
         }
         
@@ -362,7 +537,7 @@ std::function<llvm::Error(llvm::Module *)> makeCustomPassesWithOptimizingTransfo
         llvm::CGSCCAnalysisManager cgam;
         llvm::ModuleAnalysisManager mam;
 
-        llvm::PassBuilder pb(targetMachine);
+        llvm::PassBuilder pb(targetMachine, llvm::PipelineTuningOptions(), getPGOOptions());
 
         pb.registerModuleAnalyses(mam);
         pb.registerCGSCCAnalyses(cgam);
@@ -390,28 +565,42 @@ std::function<llvm::Error(llvm::Module *)> makeCustomPassesWithOptimizingTransfo
     };
 }
 
-std::function<llvm::Error(llvm::Module *)> getTransformer(bool enableOpt, int optLevel, int sizeLevel)
+std::function<llvm::Error(llvm::Module *)> getTransformer(bool enableOpt, int optLevel, int sizeLevel,
+                                                          llvm::TargetMachine *targetMachine = nullptr)
 {
 #ifdef ENABLE_EXCEPTIONS
+    // custom passes always run with -opt_level (O3 by default), even without -opt
     auto optPipeline = makeCustomPassesWithOptimizingTransformer(
-        /*optLevel=*/enableOpt ? optLevel : 0, 
-        /*targetMachine=*/nullptr);
+        /*optLevel=*/llvm::None, 
+        /*targetMachine=*/targetMachine);
 #else
     // An optimization pipeline to use within the execution engine.
     auto optPipeline = mlir::makeOptimizingTransformer(
         /*optLevel=*/enableOpt ? optLevel : 0, 
         /*sizeLevel=*/sizeLevel,
-        /*targetMachine=*/nullptr);
+        /*targetMachine=*/targetMachine);
 #endif
 
     return optPipeline;
 }
 
-int dumpLLVMIR(mlir::ModuleOp module)
+// the pipeline of the given level regardless of -opt and -opt_level, for tiers of TieredJit
+std::function<llvm::Error(llvm::Module *)> getTierTransformer(unsigned optLevel)
+{
+#ifdef ENABLE_EXCEPTIONS
+    return makeCustomPassesWithOptimizingTransformer(optLevel, /*targetMachine=*/nullptr);
+#else
+    return mlir::makeOptimizingTransformer(optLevel, /*sizeLevel=*/0, /*targetMachine=*/nullptr);
+#endif
+}
+
+int dumpLLVMIR(mlir::ModuleOp module, mlir::TimingScope &timing, CompileCache *compileCache = nullptr,
+               llvm::ArrayRef<std::string> dependencies = {})
 {
     initDialects(module);
 
     // Convert the module to LLVM IR in a new LLVM IR context.
+    auto translationTiming = timing.nest("Translation to LLVM IR");
     llvm::LLVMContext llvmContext;
     auto llvmModule = mlir::translateModuleToLLVMIR(module, llvmContext);
     if (!llvmModule)
@@ -420,11 +609,14 @@ int dumpLLVMIR(mlir::ModuleOp module)
         return -1;
     }
 
+    translationTiming.stop();
+
     // Initialize LLVM targets.
     llvm::InitializeNativeTarget();
     llvm::InitializeNativeTargetAsmPrinter();
     mlir::ExecutionEngine::setupTargetTriple(llvmModule.get());
 
+    auto llvmPipelineTiming = timing.nest("LLVM Pipeline");
     auto optPipeline = getTransformer(enableOpt, optLevel, sizeLevel);
     if (auto err = optPipeline(llvmModule.get()))
     {
@@ -432,224 +624,1720 @@ int dumpLLVMIR(mlir::ModuleOp module)
         return -1;
     }
 
+    llvmPipelineTiming.stop();
+
+    if (compileCache)
+    {
+        auto bitcodeFileName = compileCache->getTempFilePath();
+        std::error_code ec;
+        llvm::raw_fd_ostream os(bitcodeFileName, ec, llvm::sys::fs::OF_None);
+        if (!ec)
+        {
+            llvm::WriteBitcodeToFile(*llvmModule, os);
+            os.close();
+            compileCache->store(dependencies, bitcodeFileName);
+        }
+
+        llvm::sys::fs::remove(bitcodeFileName);
+    }
+
     llvm::errs() << *llvmModule << "\n";
     return 0;
 }
 
-int runJit(mlir::ModuleOp module)
+static llvm::CodeGenOpt::Level mapToCodeGenOptLevel(bool enableOpt, unsigned optLevel)
 {
-    initDialects(module);
-
-    // Initialize LLVM targets.
-    llvm::InitializeNativeTarget();
-    llvm::InitializeNativeTargetAsmPrinter();
-
-    auto optPipeline = getTransformer(enableOpt, optLevel, sizeLevel);
-
-    // If shared library implements custom mlir-runner library init and destroy
-    // functions, we'll use them to register the library with the execution
-    // engine. Otherwise we'll pass library directly to the execution engine.
-    mlir::SmallVector<mlir::SmallString<256>, 4> libPaths;
-
-    // Use absolute library path so that gdb can find the symbol table.
-    transform(clSharedLibs, std::back_inserter(libPaths), [](std::string libPath) {
-        mlir::SmallString<256> absPath(libPath.begin(), libPath.end());
-        cantFail(llvm::errorCodeToError(llvm::sys::fs::make_absolute(absPath)));
-        return absPath;
-    });
-
-    // Libraries that we'll pass to the ExecutionEngine for loading.
-    mlir::SmallVector<mlir::StringRef, 4> executionEngineLibs;
+    if (!enableOpt)
+    {
+        return llvm::CodeGenOpt::None;
+    }
 
-    using MlirRunnerInitFn = void (*)(llvm::StringMap<void *> &);
-    using MlirRunnerDestroyFn = void (*)();
+    switch (optLevel)
+    {
+    case 0:
+        return llvm::CodeGenOpt::None;
+    case 1:
+        return llvm::CodeGenOpt::Less;
+    case 2:
+        return llvm::CodeGenOpt::Default;
+    default:
+        return llvm::CodeGenOpt::Aggressive;
+    }
+}
 
-    llvm::StringMap<void *> exportSymbols;
-    mlir::SmallVector<MlirRunnerDestroyFn> destroyFns;
+std::unique_ptr<llvm::TargetMachine> createHostTargetMachine()
+{
+    auto targetTriple = llvm::sys::getProcessTriple();
 
-    // Handle libraries that do support mlir-runner init/destroy callbacks.
-    for (auto &libPath : libPaths)
+    std::string errorMessage;
+    auto target = llvm::TargetRegistry::lookupTarget(targetTriple, errorMessage);
+    if (!target)
     {
-        LLVM_DEBUG(llvm::dbgs() << "loading lib at path: " << libPath.c_str() << "\n";);
-
-        std::string errMsg;
-        auto lib = llvm::sys::DynamicLibrary::getPermanentLibrary(libPath.c_str(), &errMsg);
+        llvm::errs() << "Can't find target for triple " << targetTriple << ": " << errorMessage << "\n";
+        return nullptr;
+    }
 
-        if (errMsg.size() > 0)
+    // tune code for the host CPU, the same way as ExecutionEngine does for JIT
+    llvm::SubtargetFeatures features;
+    llvm::StringMap<bool> hostFeatures;
+    if (llvm::sys::getHostCPUFeatures(hostFeatures))
+    {
+        for (auto &feature : hostFeatures)
         {
-            llvm::errs() << "Loading error lib: " << errMsg << "\n";
-            return -1;
+            features.AddFeature(feature.first(), feature.second);
         }
+    }
 
-        LLVM_DEBUG(llvm::dbgs() << "loaded path: " << libPath.c_str() << "\n";);
+    llvm::TargetOptions options;
+    std::unique_ptr<llvm::TargetMachine> targetMachine(
+        target->createTargetMachine(targetTriple, llvm::sys::getHostCPUName(), features.getString(), options, llvm::Reloc::PIC_,
+                                    llvm::None, mapToCodeGenOptLevel(enableOpt, optLevel)));
+    if (!targetMachine)
+    {
+        llvm::errs() << "Can't create target machine for triple " << targetTriple << "\n";
+        return nullptr;
+    }
 
-        void *initSym = lib.getAddressOfSymbol("__mlir_runner_init");
-        if (!initSym)
-        {
-            LLVM_DEBUG(llvm::dbgs() << "missing __mlir_runner_init";);
-        }
+    return targetMachine;
+}
 
-        void *destroySim = lib.getAddressOfSymbol("__mlir_runner_destroy");
-        if (!destroySim)
-        {
-            LLVM_DEBUG(llvm::dbgs() << "missing __mlir_runner_destroy";);
-        }
+std::string getDefaultOutputFileName(llvm::StringRef inputFilename, llvm::StringRef ext)
+{
+    if (inputFilename == "-")
+    {
+        return ("out" + ext).str();
+    }
 
-        // Library does not support mlir runner, load it with ExecutionEngine.
-        if (!initSym || !destroySim)
-        {
-            executionEngineLibs.push_back(libPath);
-            continue;
-        }
+    llvm::SmallString<256> outputPath(llvm::sys::path::filename(inputFilename));
+    llvm::sys::path::replace_extension(outputPath, ext);
+    return outputPath.str().str();
+}
 
-        LLVM_DEBUG(llvm::dbgs() << "added path: " << libPath.c_str() << "\n";);
+int emitObjectFile(llvm::Module &llvmModule, llvm::TargetMachine &targetMachine, llvm::StringRef objFileName,
+                   mlir::TimingScope &timing)
+{
+    llvmModule.setDataLayout(targetMachine.createDataLayout());
+    llvmModule.setTargetTriple(targetMachine.getTargetTriple().getTriple());
 
-        auto initFn = reinterpret_cast<MlirRunnerInitFn>(initSym);
-        initFn(exportSymbols);
+    auto llvmPipelineTiming = timing.nest("LLVM Pipeline");
+    auto optPipeline = getTransformer(enableOpt, optLevel, sizeLevel, &targetMachine);
+    if (auto err = optPipeline(&llvmModule))
+    {
+        llvm::errs() << "Failed to optimize LLVM IR " << err << "\n";
+        return -1;
+    }
 
-        auto destroyFn = reinterpret_cast<MlirRunnerDestroyFn>(destroySim);
-        destroyFns.push_back(destroyFn);
+    llvmPipelineTiming.stop();
+
+    auto codeEmissionTiming = timing.nest("Code Emission");
+    std::error_code ec;
+    llvm::ToolOutputFile objFile(objFileName, ec, llvm::sys::fs::OF_None);
+    if (ec)
+    {
+        llvm::errs() << "Could not open output file: " << ec.message() << "\n";
+        return -1;
     }
 
-    auto noGC = false;
+    llvm::legacy::PassManager codeGenPasses;
+    if (targetMachine.addPassesToEmitFile(codeGenPasses, objFile.os(), nullptr, llvm::CGFT_ObjectFile))
+    {
+        llvm::errs() << "Target does not support emitting object file\n";
+        return -1;
+    }
 
-    // Build a runtime symbol map from the config and exported symbols.
-    auto runtimeSymbolMap = [&](llvm::orc::MangleAndInterner interner) {
-        auto symbolMap = llvm::orc::SymbolMap();
-        for (auto &exportSymbol : exportSymbols)
-        {
-            LLVM_DEBUG(llvm::dbgs() << "loading symbol: " << exportSymbol.getKey() << "\n";);
-            symbolMap[interner(exportSymbol.getKey())] = llvm::JITEvaluatedSymbol::fromPointer(exportSymbol.getValue());
-        }
+    codeGenPasses.run(llvmModule);
 
-#ifdef ENABLE_STACK_EXEC
-        // adding my ref to __enable_execute_stack
-        symbolMap[interner("__enable_execute_stack")] = llvm::JITEvaluatedSymbol::fromPointer(_mlir__enable_execute_stack);
-#endif        
+    objFile.keep();
+    return 0;
+}
 
-        if (!disableGC && symbolMap.count(interner("GC_init")) == 0)
-        {
-            noGC = true;
-        }
+std::string getPartitionFileName(llvm::StringRef objFileName, unsigned index)
+{
+    llvm::SmallString<256> partFileName(objFileName);
+    auto ext = llvm::sys::path::extension(objFileName).str();
+    llvm::sys::path::replace_extension(partFileName, llvm::formatv(".{0}{1}", index, ext).str());
+    return partFileName.str().str();
+}
 
-        return symbolMap;
-    };
+// splits module into partitions and runs optimization and code generation for each of them in own thread,
+// each partition gets own LLVMContext as LLVMContext can't be shared between threads
+int emitObjectFilesInParallel(llvm::Module &llvmModule, llvm::StringRef objFileName, llvm::SmallVectorImpl<std::string> &objFileNames,
+                              mlir::TimingScope &timing)
+{
+    auto splitTiming = timing.nest("Module Splitting");
+    llvm::SmallVector<llvm::SmallString<0>> partitions;
+    llvm::SplitModule(llvmModule, codeGenThreads, [&](std::unique_ptr<llvm::Module> partition) {
+        llvm::SmallString<0> bitcode;
+        llvm::raw_svector_ostream os(bitcode);
+        llvm::WriteBitcodeToFile(*partition, os);
+        partitions.push_back(std::move(bitcode));
+    });
 
-    // Create an MLIR execution engine. The execution engine eagerly JIT-compiles
-    // the module.
-    mlir::ExecutionEngineOptions engineOptions;
-    engineOptions.transformer = optPipeline;
-    auto maybeEngine = mlir::ExecutionEngine::create(module, engineOptions);
-    assert(maybeEngine && "failed to construct an execution engine");
-    auto &engine = maybeEngine.get();
+    splitTiming.stop();
 
-    engine->registerSymbols(runtimeSymbolMap);
-    if (noGC)
+    for (auto index : llvm::seq<unsigned>(0, partitions.size()))
     {
-#ifdef WIN32
-#define LIB_EXT "dll"
-#else
-#define LIB_EXT "so"
-#endif
-        llvm::errs() << "JIT initialization failed. Missing GC library. Did you forget to provide it via "
-                        "'--shared-libs=TypeScriptRuntime." LIB_EXT "'? or you can switch it off by using '-nogc'\n";
-        return -1;
+        objFileNames.push_back(getPartitionFileName(objFileName, index));
     }
 
-    if (dumpObjectFile)
+    llvm::SmallVector<int> results(partitions.size(), 0);
     {
-        auto expectedFPtr = engine->lookup(mainFuncName);
-        if (!expectedFPtr)
+        auto parallelTiming = timing.nest("Parallel Code Generation");
+        llvm::ThreadPool threadPool(llvm::hardware_concurrency(codeGenThreads));
+        for (auto index : llvm::seq<unsigned>(0, partitions.size()))
         {
-            llvm::errs() << expectedFPtr.takeError();
-            return -1;
+            threadPool.async([&, index]() {
+                auto partitionTiming = parallelTiming.nest("Partition");
+                llvm::LLVMContext partitionContext;
+                auto partitionModule = llvm::parseBitcodeFile(
+                    llvm::MemoryBufferRef(llvm::StringRef(partitions[index].data(), partitions[index].size()), "<split-module>"),
+                    partitionContext);
+                if (!partitionModule)
+                {
+                    llvm::consumeError(partitionModule.takeError());
+                    results[index] = -1;
+                    return;
+                }
+
+                auto targetMachine = createHostTargetMachine();
+                if (!targetMachine)
+                {
+                    results[index] = -1;
+                    return;
+                }
+
+                results[index] = emitObjectFile(**partitionModule, *targetMachine, objFileNames[index], partitionTiming);
+            });
         }
 
-        engine->dumpToObjectFile(objectFilename.empty() ? inputFilename + ".o" : objectFilename);
-        return 0;
+        threadPool.wait();
     }
 
-    if (module.lookupSymbol("__mlir_gctors"))
+    for (auto result : results)
     {
-        auto gctorsResult = engine->invokePacked("__mlir_gctors");
-        if (gctorsResult)
+        if (result)
         {
-            llvm::errs() << "JIT calling global constructors failed, error: " << gctorsResult << "\n";
-            return -1;
+            return result;
         }
     }
 
-    // Invoke the JIT-compiled function.
-    auto invocationResult = engine->invokePacked(mainFuncName);
-
-    // Run all dynamic library destroy callbacks to prepare for the shutdown.
-    llvm::for_each(destroyFns, [](MlirRunnerDestroyFn destroy) { destroy(); });
-
-    if (invocationResult)
-    {
-        llvm::errs() << "JIT invocation failed, error: " << invocationResult << "\n";
-        return -1;
-    }
-
     return 0;
 }
 
-int main(int argc, char **argv)
+// module is split into several object files (objFileNames) only when 'allowPartitions' is set
+int emitObjectFiles(mlir::ModuleOp module, llvm::StringRef objFileName, llvm::SmallVectorImpl<std::string> &objFileNames,
+                    mlir::TimingScope &timing, bool allowPartitions)
 {
-    // Register any command line options.
-    mlir::registerAsmPrinterCLOptions();
-    mlir::registerMLIRContextCLOptions();
-    mlir::registerPassManagerCLOptions();
-    mlir::registerDefaultTimingManagerCLOptions();
-    mlir::DebugCounter::registerCLOptions();
+    initDialects(module);
 
-    cl::ParseCommandLineOptions(argc, argv, "TypeScript compiler\n");
+    // Initialize LLVM targets.
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
 
-    if (emitAction == Action::DumpAST)
+    // Convert the module to LLVM IR in a new LLVM IR context.
+    auto translationTiming = timing.nest("Translation to LLVM IR");
+    llvm::LLVMContext llvmContext;
+    auto llvmModule = mlir::translateModuleToLLVMIR(module, llvmContext);
+    if (!llvmModule)
     {
-        return dumpAST();
+        llvm::errs() << "Failed to emit LLVM IR\n";
+        return -1;
     }
 
-    // If we aren't dumping the AST, then we are compiling with/to MLIR.
-
-    mlir::MLIRContext context;
-    // Load our Dialect in this MLIR Context.
-    context.getOrLoadDialect<mlir::typescript::TypeScriptDialect>();
-    context.getOrLoadDialect<mlir::arith::ArithmeticDialect>();
-    context.getOrLoadDialect<mlir::math::MathDialect>();
-    context.getOrLoadDialect<mlir::cf::ControlFlowDialect>();
-    context.getOrLoadDialect<mlir::func::FuncDialect>();
-    context.getOrLoadDialect<mlir::LLVM::LLVMDialect>();
-#ifdef ENABLE_ASYNC
-    context.getOrLoadDialect<mlir::async::AsyncDialect>();
-#endif
+    translationTiming.stop();
 
-    mlir::OwningOpRef<mlir::ModuleOp> module;
-    if (int error = loadAndProcessMLIR(context, module))
+    if (codeGenThreads > 1 && allowPartitions)
     {
-        return error;
+        return emitObjectFilesInParallel(*llvmModule, objFileName, objFileNames, timing);
     }
 
-    // If we aren't exporting to non-mlir, then we are done.
-    bool isOutputingMLIR = emitAction <= Action::DumpMLIRLLVM;
-    if (isOutputingMLIR)
+    auto targetMachine = createHostTargetMachine();
+    if (!targetMachine)
     {
-        module->dump();
-        return 0;
+        return -1;
     }
 
-    // Check to see if we are compiling to LLVM IR.
-    if (emitAction == Action::DumpLLVMIR)
+    objFileNames.push_back(objFileName.str());
+    return emitObjectFile(*llvmModule, *targetMachine, objFileName, timing);
+}
+
+// profile runtime of compiler-rt, it is searched in the library paths (-L) as the name differs between layouts of
+// the runtime directory of clang
+std::string findProfileRuntimeLibrary()
+{
+    auto arch = llvm::Triple(llvm::sys::getProcessTriple()).getArchName();
+#ifdef WIN32
+    std::string names[] = {"clang_rt.profile.lib", ("clang_rt.profile-" + arch + ".lib").str()};
+#else
+    std::string names[] = {"libclang_rt.profile.a", ("libclang_rt.profile-" + arch + ".a").str()};
+#endif
+    for (auto &libPath : clLibPaths)
     {
-        return dumpLLVMIR(*module);
+        for (auto &name : names)
+        {
+            llvm::SmallString<256> path(libPath);
+            llvm::sys::path::append(path, name);
+            if (llvm::sys::fs::exists(path))
+            {
+                return path.str().str();
+            }
+        }
     }
 
-    // Otherwise, we must be running the jit.
-    if (emitAction == Action::RunJIT)
+    return "";
+}
+
+void removeFiles(llvm::ArrayRef<std::string> fileNames)
+{
+    for (auto &fileName : fileNames)
     {
-        return runJit(*module);
+        llvm::sys::fs::remove(fileName);
+    }
+}
+
+int runLinker(llvm::SmallVectorImpl<std::string> &args)
+{
+#ifdef WIN32
+    auto defaultLinker = "lld-link";
+#else
+    auto defaultLinker = "gcc";
+#endif
+
+    auto linkerPath = llvm::sys::findProgramByName(linkerName.empty() ? defaultLinker : linkerName.getValue());
+    if (!linkerPath)
+    {
+        llvm::errs() << "Can't find linker: " << linkerPath.getError().message() << "\n";
+        return -1;
+    }
+
+    args.insert(args.begin(), *linkerPath);
+
+    llvm::SmallVector<llvm::StringRef> argRefs(args.begin(), args.end());
+
+    LLVM_DEBUG(llvm::dbgs() << "linking: "; for (auto &arg : argRefs) llvm::dbgs() << arg << " "; llvm::dbgs() << "\n";);
+
+    std::string errMsg;
+    auto returnCode = llvm::sys::ExecuteAndWait(argRefs[0], argRefs, llvm::None, {}, 0, 0, &errMsg);
+    if (returnCode != 0)
+    {
+        llvm::errs() << "Linking failed, code: " << returnCode << " " << errMsg << "\n";
+        return -1;
+    }
+
+    return 0;
+}
+
+int linkExecutable(llvm::ArrayRef<std::string> objFileNames, llvm::StringRef exeFileName)
+{
+    std::string profileRuntimeLibrary;
+    if (profileGenerate)
+    {
+        profileRuntimeLibrary = findProfileRuntimeLibrary();
+        if (profileRuntimeLibrary.empty())
+        {
+            llvm::errs() << "Profile runtime (clang_rt.profile) is not found, use -L<path> to the runtime libraries of "
+                            "clang (lib/clang/<version>/lib/<target> of LLVM)\n";
+            return -1;
+        }
+    }
+
+    llvm::SmallVector<std::string> args;
+#ifdef WIN32
+    args.push_back(("/out:" + exeFileName).str());
+    args.append(objFileNames.begin(), objFileNames.end());
+    for (auto &libPath : clLibPaths)
+    {
+        args.push_back("/libpath:" + libPath);
+    }
+
+    args.push_back("/defaultlib:libcmt.lib");
+    args.push_back("libvcruntime.lib");
+    if (!disableGC)
+    {
+        args.push_back("gcmt-lib.lib");
+    }
+
+    if (profileGenerate)
+    {
+        args.push_back("/include:__llvm_profile_runtime");
+        args.push_back(profileRuntimeLibrary);
+    }
+
+    for (auto &lib : clLibs)
+    {
+        args.push_back(lib + ".lib");
+    }
+#else
+    args.push_back("-o");
+    args.push_back(exeFileName.str());
+    args.append(objFileNames.begin(), objFileNames.end());
+    for (auto &libPath : clLibPaths)
+    {
+        args.push_back("-L" + libPath);
+    }
+
+    if (!disableGC)
+    {
+        args.push_back("-lgcmt-lib");
+    }
+
+    if (profileGenerate)
+    {
+        // instrumented code doesn't reference the profile runtime on Linux
+        args.push_back("-Wl,-u,__llvm_profile_runtime");
+        args.push_back(profileRuntimeLibrary);
+    }
+
+    for (auto &lib : clLibs)
+    {
+        args.push_back("-l" + lib);
+    }
+
+    args.push_back("-frtti");
+    args.push_back("-fexceptions");
+    args.push_back("-lstdc++");
+    args.push_back("-lm");
+    args.push_back("-lpthread");
+#endif
+
+    return runLinker(args);
+}
+
+// lld-link can't produce relocatable object file (a library made by 'lld-link /lib' is not an object file and its members
+// are linked only when they are referenced), so on Windows module is not split when one object file is needed
+bool canMergeObjectFiles()
+{
+#ifdef WIN32
+    return false;
+#else
+    return true;
+#endif
+}
+
+// merges object files of partitions into one relocatable object file
+int mergeObjectFiles(llvm::ArrayRef<std::string> objFileNames, llvm::StringRef objFileName)
+{
+    if (!canMergeObjectFiles())
+    {
+        llvm::errs() << "Object files can't be merged into one relocatable object file on this platform\n";
+        return -1;
+    }
+
+    llvm::SmallVector<std::string> args;
+    args.push_back("-r");
+    args.push_back("-nostdlib");
+    args.push_back("-o");
+    args.push_back(objFileName.str());
+    args.append(objFileNames.begin(), objFileNames.end());
+    return runLinker(args);
+}
+
+int createTemporaryObjectFile(llvm::StringRef prefix, std::string &objFileName)
+{
+    llvm::SmallString<256> tempObjFileName;
+#ifdef WIN32
+    auto ec = llvm::sys::fs::createTemporaryFile(prefix, "obj", tempObjFileName);
+#else
+    auto ec = llvm::sys::fs::createTemporaryFile(prefix, "o", tempObjFileName);
+#endif
+    if (ec)
+    {
+        llvm::errs() << "Could not create object file: " << ec.message() << "\n";
+        return -1;
+    }
+
+    objFileName = tempObjFileName.str().str();
+    return 0;
+}
+
+std::string getObjOutputFileName(llvm::StringRef inputFilename)
+{
+#ifdef WIN32
+    auto defaultObjFileName = getDefaultOutputFileName(inputFilename, ".obj");
+#else
+    auto defaultObjFileName = getDefaultOutputFileName(inputFilename, ".o");
+#endif
+    return outputFilename.empty() ? defaultObjFileName : outputFilename.getValue();
+}
+
+std::string getExeOutputFileName(llvm::StringRef inputFilename)
+{
+#ifdef WIN32
+    auto defaultExeFileName = getDefaultOutputFileName(inputFilename, ".exe");
+#else
+    auto defaultExeFileName = getDefaultOutputFileName(inputFilename, "");
+#endif
+    return outputFilename.empty() ? defaultExeFileName : outputFilename.getValue();
+}
+
+std::string getCompileCacheOptionsKey()
+{
+    // obj and exe share the same artifact - object file, JIT produces objects for different code model
+    auto artifactKind = emitAction == Action::DumpLLVMIR ? "bc" : emitAction == Action::RunJIT ? "jit" : "obj";
+    // code depends on the content of the profile, not on its name
+    std::string profileKey;
+    if (!profileUse.empty())
+    {
+        auto profileOrErr = llvm::MemoryBuffer::getFile(profileUse);
+        profileKey = profileOrErr ? llvm::toHex(llvm::MD5::hash(llvm::arrayRefFromStringRef(profileOrErr.get()->getBuffer())))
+                                  : "missing";
+    }
+
+    return llvm::formatv("{0}|opt={1}|opt_level={2}|size_level={3}|nogc={4}|{5}|{6}|profile_generate={7}|profile_use={8}",
+                         artifactKind, enableOpt.getValue(), optLevel.getValue(), sizeLevel.getValue(), disableGC.getValue(),
+                         llvm::sys::getProcessTriple(), llvm::sys::getHostCPUName(), profileGenerate.getValue(), profileKey)
+        .str();
+}
+
+int compileToObj(mlir::ModuleOp module, llvm::StringRef inputFilename, mlir::TimingScope &timing, CompileCache *compileCache = nullptr,
+                 llvm::ArrayRef<std::string> dependencies = {}, llvm::ArrayRef<std::string> importedModules = {})
+{
+    auto objFileName = getObjOutputFileName(inputFilename);
+
+    llvm::SmallVector<std::string> objFileNames;
+    auto result = emitObjectFiles(module, objFileName, objFileNames, timing, canMergeObjectFiles());
+    if (objFileNames.size() > 1)
+    {
+        if (!result)
+        {
+            auto linkingTiming = timing.nest("Linking");
+            result = mergeObjectFiles(objFileNames, objFileName);
+        }
+
+        // object files of partitions are removed when emission fails as well
+        removeFiles(objFileNames);
+    }
+
+    if (!result && compileCache)
+    {
+        compileCache->store(dependencies, objFileName, importedModules);
+    }
+
+    return result;
+}
+
+// imported module is compiled into own object file, the importer has only declarations of its exported symbols
+int compileImportedModule(mlir::MLIRContext &context, llvm::StringRef moduleFilename, std::string &objFileName,
+                          std::vector<std::string> &importedModules, llvm::SmallVectorImpl<std::string> &tempFileNames,
+                          mlir::TimingScope &timing)
+{
+    std::unique_ptr<CompileCache> compileCache;
+    if (!cacheDir.empty())
+    {
+        auto cacheTiming = timing.nest("Cache Lookup");
+        compileCache = std::make_unique<CompileCache>(cacheDir);
+
+        auto fileOrErr = llvm::MemoryBuffer::getFile(moduleFilename);
+        if (fileOrErr && compileCache->lookup(moduleFilename, fileOrErr.get()->getBuffer(), getCompileCacheOptionsKey(), ".o"))
+        {
+            objFileName = compileCache->getArtifactPath().str();
+            importedModules = compileCache->getImportedModules().vec();
+            return 0;
+        }
+    }
+
+    mlir::OwningOpRef<mlir::ModuleOp> module;
+    std::vector<std::string> dependencies;
+    if (int error = loadAndProcessMLIR(context, moduleFilename, module, timing, &dependencies, &importedModules))
+    {
+        return error;
+    }
+
+    // imported modules of different folders can have the same name
+    std::string tempObjFileName;
+    if (createTemporaryObjectFile(llvm::sys::path::stem(moduleFilename), tempObjFileName))
+    {
+        return -1;
+    }
+
+    tempFileNames.push_back(tempObjFileName);
+
+    llvm::SmallVector<std::string> objFileNames;
+    auto result = emitObjectFiles(*module, tempObjFileName, objFileNames, timing, canMergeObjectFiles());
+    if (objFileNames.size() > 1)
+    {
+        if (!result)
+        {
+            result = mergeObjectFiles(objFileNames, tempObjFileName);
+        }
+
+        removeFiles(objFileNames);
+    }
+
+    if (result)
+    {
+        return result;
+    }
+
+    if (compileCache)
+    {
+        compileCache->store(dependencies, tempObjFileName, importedModules);
+    }
+
+    objFileName = tempObjFileName;
+    return 0;
+}
+
+// compiles the imported modules and the modules imported by them, a module is added after the modules it imports (in
+// the order of imports), so global constructors of the modules run in the order of evaluation of TypeScript modules
+// when object files are linked in this order. A module which is being compiled (cycle of imports) is skipped.
+int compileImportedModules(mlir::MLIRContext &context, llvm::ArrayRef<std::string> importedModules, llvm::StringSet<> &compiledModules,
+                           llvm::SmallVectorImpl<std::string> &objFileNames, llvm::SmallVectorImpl<std::string> &tempFileNames,
+                           mlir::TimingScope &importsTiming)
+{
+    for (auto &importedModule : importedModules)
+    {
+        auto inserted = compiledModules.insert(importedModule);
+        if (!inserted.second)
+        {
+            continue;
+        }
+
+        auto moduleFilename = inserted.first->getKey();
+        std::string objFileName;
+        std::vector<std::string> moduleImportedModules;
+        {
+            auto moduleTiming = importsTiming.nest(moduleFilename.data(), [=]() { return moduleFilename.str(); });
+            if (int error = compileImportedModule(context, moduleFilename, objFileName, moduleImportedModules, tempFileNames,
+                                                  moduleTiming))
+            {
+                llvm::errs() << "Compilation of imported module " << moduleFilename << " failed\n";
+                return error;
+            }
+        }
+
+        if (int error = compileImportedModules(context, moduleImportedModules, compiledModules, objFileNames, tempFileNames,
+                                               importsTiming))
+        {
+            return error;
+        }
+
+        objFileNames.push_back(objFileName);
+    }
+
+    return 0;
+}
+
+// object files of imported modules to link them before the object files of the importer
+int compileImportedModules(mlir::MLIRContext *context, llvm::ArrayRef<std::string> importedModules,
+                           llvm::SmallVectorImpl<std::string> &objFileNames, llvm::SmallVectorImpl<std::string> &tempFileNames,
+                           mlir::TimingScope &timing)
+{
+    if (importedModules.empty())
+    {
+        return 0;
+    }
+
+    std::unique_ptr<mlir::MLIRContext> ownContext;
+    if (!context)
+    {
+        ownContext = std::make_unique<mlir::MLIRContext>();
+        loadDialects(*ownContext);
+        context = ownContext.get();
+    }
+
+    auto importsTiming = timing.nest("Imported Modules");
+
+    llvm::StringSet<> compiledModules;
+    return compileImportedModules(*context, importedModules, compiledModules, objFileNames, tempFileNames, importsTiming);
+}
+
+int compileToExe(mlir::ModuleOp module, llvm::StringRef inputFilename, mlir::TimingScope &timing, CompileCache *compileCache = nullptr,
+                 llvm::ArrayRef<std::string> dependencies = {}, llvm::ArrayRef<std::string> importedModules = {})
+{
+    // keep object files only when it is asked explicitly, otherwise object file of the input is created in temp folder,
+    // so <input>.o of the user is not overwritten
+    auto keepObjFile = !objectFilename.empty();
+    if (keepObjFile && codeGenThreads > 1 && !canMergeObjectFiles())
+    {
+        llvm::errs() << "-object-filename can't be used with --codegen-threads on this platform, object files of "
+                        "partitions can't be merged into one\n";
+        return -1;
+    }
+
+    std::string objFileName;
+    if (keepObjFile)
+    {
+        objFileName = objectFilename.getValue();
+    }
+    else if (createTemporaryObjectFile(inputFilename == "-" ? "out" : llvm::sys::path::stem(inputFilename), objFileName))
+    {
+        return -1;
+    }
+
+    // the cache and -object-filename keep one object file per input, otherwise object files of partitions are passed
+    // to the linker as they are
+    auto mergePartitions = compileCache || keepObjFile;
+    llvm::SmallVector<std::string> objFileNames;
+    auto result = emitObjectFiles(module, objFileName, objFileNames, timing, !mergePartitions || canMergeObjectFiles());
+    llvm::SmallVector<std::string> partitionFileNames;
+    if (objFileNames.size() > 1)
+    {
+        partitionFileNames.assign(objFileNames.begin(), objFileNames.end());
+        if (mergePartitions)
+        {
+            if (!result)
+            {
+                result = mergeObjectFiles(partitionFileNames, objFileName);
+            }
+
+            objFileNames.assign({objFileName});
+        }
+    }
+
+    if (!result && compileCache)
+    {
+        compileCache->store(dependencies, objFileName, importedModules);
+    }
+
+    llvm::SmallVector<std::string> linkObjFileNames;
+    llvm::SmallVector<std::string> tempFileNames;
+    if (!result)
+    {
+        result = compileImportedModules(module.getContext(), importedModules, linkObjFileNames, tempFileNames, timing);
+        linkObjFileNames.append(objFileNames.begin(), objFileNames.end());
+    }
+
+    if (!result)
+    {
+        auto linkingTiming = timing.nest("Linking");
+        result = linkExecutable(linkObjFileNames, getExeOutputFileName(inputFilename));
+    }
+
+    // object files of partitions are removed when the build fails as well
+    removeFiles(partitionFileNames);
+    if (!keepObjFile)
+    {
+        llvm::sys::fs::remove(objFileName);
+    }
+
+    removeFiles(tempFileNames);
+    return result;
+}
+
+// returns true when output is produced from the cached artifact
+bool runFromCompileCache(CompileCache &compileCache, llvm::StringRef inputFilename, mlir::TimingScope &timing, int &result)
+{
+    auto fileOrErr = llvm::MemoryBuffer::getFile(inputFilename);
+    if (!fileOrErr)
+    {
+        return false;
+    }
+
+    auto ext = emitAction == Action::DumpLLVMIR ? ".bc" : ".o";
+    if (!compileCache.lookup(inputFilename, fileOrErr.get()->getBuffer(), getCompileCacheOptionsKey(), ext))
+    {
+        return false;
+    }
+
+    auto artifactPath = compileCache.getArtifactPath();
+    switch (emitAction)
+    {
+    case Action::DumpLLVMIR: {
+        auto bitcodeOrErr = llvm::MemoryBuffer::getFile(artifactPath);
+        if (!bitcodeOrErr)
+        {
+            return false;
+        }
+
+        llvm::LLVMContext llvmContext;
+        auto llvmModule = llvm::parseBitcodeFile(bitcodeOrErr.get()->getMemBufferRef(), llvmContext);
+        if (!llvmModule)
+        {
+            llvm::consumeError(llvmModule.takeError());
+            return false;
+        }
+
+        llvm::errs() << **llvmModule << "\n";
+        result = 0;
+        return true;
+    }
+    case Action::DumpObj:
+        if (auto ec = llvm::sys::fs::copy_file(artifactPath, getObjOutputFileName(inputFilename)))
+        {
+            llvm::errs() << "Could not write output file: " << ec.message() << "\n";
+            result = -1;
+            return true;
+        }
+
+        result = 0;
+        return true;
+    case Action::BuildExe: {
+        llvm::SmallVector<std::string> objFileNames;
+        llvm::SmallVector<std::string> tempFileNames;
+        result = compileImportedModules(serverContext, compileCache.getImportedModules(), objFileNames, tempFileNames, timing);
+        objFileNames.push_back(artifactPath.str());
+        if (!result)
+        {
+            auto linkingTiming = timing.nest("Linking");
+            result = linkExecutable(objFileNames, getExeOutputFileName(inputFilename));
+        }
+
+        removeFiles(tempFileNames);
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+void reportMissingGCLibrary()
+{
+#ifdef WIN32
+#define LIB_EXT "dll"
+#else
+#define LIB_EXT "so"
+#endif
+    llvm::errs() << "JIT initialization failed. Missing GC library. Did you forget to provide it via "
+                    "'--shared-libs=TypeScriptRuntime." LIB_EXT "'? or you can switch it off by using '-nogc'\n";
+}
+
+// profile of JIT run, sections of the instrumented code are placed by the profile runtime (TypeScriptRuntime), it
+// writes them after the run
+struct JitProfileSections
+{
+    using AllocateSectionFn = void *(*)(int, uint64_t, uint32_t);
+
+    std::mutex mutex;
+    // value of __llvm_profile_raw_version of the instrumented modules
+    uint64_t version = INSTR_PROF_RAW_VERSION | VARIANT_MASK_IR_PROF;
+    // __tsc_profile_allocate_section of the profile runtime
+    AllocateSectionFn allocateSection = nullptr;
+};
+
+// profile sections of all loaded objects are put one after another into the ranges of the profile runtime, as the
+// linker merges them in executable, so compiler-rt finds them as in executable
+class ProfilingMemoryManager : public llvm::SectionMemoryManager
+{
+  public:
+    ProfilingMemoryManager(JitProfileSections &profileSections) : profileSections(profileSections)
+    {
+    }
+
+    uint8_t *allocateDataSection(uintptr_t size, unsigned alignment, unsigned sectionID, llvm::StringRef sectionName,
+                                 bool isReadOnly) override
+    {
+        // the same order as kinds of __tsc_profile_allocate_section
+        static const llvm::InstrProfSectKind kinds[] = {llvm::IPSK_data, llvm::IPSK_cnts, llvm::IPSK_name, llvm::IPSK_vnodes};
+        for (auto index = 0; index < 4; index++)
+        {
+            auto kindSectionName = llvm::getInstrProfSectionName(kinds[index], triple.getObjectFormat(), false);
+            // COFF sections have suffix of the order ('$M')
+            if (sectionName == kindSectionName || sectionName.startswith(kindSectionName + "$"))
+            {
+                auto memory = profileSections.allocateSection(index, size, alignment);
+                if (!memory)
+                {
+                    llvm::errs() << "No room for profile section " << sectionName << " of JIT-ed code\n";
+                }
+
+                return static_cast<uint8_t *>(memory);
+            }
+        }
+
+        return llvm::SectionMemoryManager::allocateDataSection(size, alignment, sectionID, sectionName, isReadOnly);
+    }
+
+  private:
+    JitProfileSections &profileSections;
+    llvm::Triple triple{llvm::sys::getProcessTriple()};
+};
+
+static llvm::orc::LLJITBuilderState::ObjectLinkingLayerCreator getProfilingObjectLinkingLayerCreator(JitProfileSections &profileSections)
+{
+    return [&](llvm::orc::ExecutionSession &es, const llvm::Triple &triple) -> llvm::Expected<std::unique_ptr<llvm::orc::ObjectLayer>> {
+        auto objectLinkingLayer = std::make_unique<llvm::orc::RTDyldObjectLinkingLayer>(
+            es, [&]() { return std::make_unique<ProfilingMemoryManager>(profileSections); });
+        if (triple.isOSBinFormatCOFF())
+        {
+            // the same as default object linking layer of LLJIT
+            objectLinkingLayer->setOverrideObjectFlagsWithResponsibilityFlags(true);
+        }
+
+        // instrumentation adds counters and records after the symbols of the module are collected, profile sections are
+        // not referenced by the code, so they are not loaded by default
+        objectLinkingLayer->setAutoClaimResponsibilityForObjectSymbols(true);
+        objectLinkingLayer->setProcessAllSections(true);
+
+        return std::move(objectLinkingLayer);
+    };
+}
+
+// each instrumented module (each function in lazy mode) defines the version variable, JIT doesn't allow duplicates
+static void takeProfileVersion(llvm::Module &module, JitProfileSections &profileSections)
+{
+    auto versionVar = module.getNamedGlobal(INSTR_PROF_QUOTE(INSTR_PROF_RAW_VERSION_VAR));
+    if (!versionVar)
+    {
+        return;
+    }
+
+    if (auto version = llvm::dyn_cast_or_null<llvm::ConstantInt>(versionVar->getInitializer()))
+    {
+        std::lock_guard<std::mutex> lock(profileSections.mutex);
+        profileSections.version = version->getZExtValue();
+    }
+
+    versionVar->setComdat(nullptr);
+    versionVar->setLinkage(llvm::GlobalValue::InternalLinkage);
+}
+
+// the profile runtime (TypeScriptRuntime) writes the profile while JIT-ed code is alive
+static int writeJitProfile(llvm::orc::LLJIT &jit, JitProfileSections &profileSections)
+{
+    using WriteFn = int (*)(uint64_t);
+
+    auto symbolOrErr = jit.lookup("__tsc_profile_write");
+    if (!symbolOrErr)
+    {
+        llvm::errs() << "Failed to write profile: " << symbolOrErr.takeError() << "\n";
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> lock(profileSections.mutex);
+    if (reinterpret_cast<WriteFn>(symbolOrErr->getAddress())(profileSections.version))
+    {
+        llvm::errs() << "Failed to write profile\n";
+        return -1;
+    }
+
+    return 0;
+}
+
+// the integer result of main is the exit code, the bits above the width of a narrower result are undefined in the
+// register (or in the memory of a packed result), so it is extended here (boolean results as 0/1)
+static int getMainExitCode(int64_t result, unsigned bits)
+{
+    return bits == 1 ? static_cast<int>(result & 1) : static_cast<int>(llvm::SignExtend64(result, bits));
+}
+
+// JIT on ORC directly: with --jit-lazy functions are compiled (and optimized) on the first call through lazy
+// call-through stubs, with --jit-tiered hot functions are recompiled with optimizations (see TieredJit), with object
+// cache optimization and code generation are skipped for cached modules
+int runOrcJit(mlir::ModuleOp module, mlir::TimingScope &timing,
+              llvm::function_ref<llvm::orc::SymbolMap(llvm::orc::MangleAndInterner)> runtimeSymbolMap, bool &noGC,
+              JitObjectCache *objectCache, JitProfileSections::AllocateSectionFn profileAllocateSection)
+{
+    auto materializationTiming = timing.nest("JIT Materialization");
+
+    auto llvmContext = std::make_unique<llvm::LLVMContext>();
+    auto llvmModule = mlir::translateModuleToLLVMIR(module, *llvmContext);
+    if (!llvmModule)
+    {
+        llvm::errs() << "Failed to emit LLVM IR\n";
+        return -1;
+    }
+
+    auto compileFunctionCreator =
+        [&](llvm::orc::JITTargetMachineBuilder jtmb) -> llvm::Expected<std::unique_ptr<llvm::orc::IRCompileLayer::IRCompiler>> {
+        auto targetMachineOrErr = jtmb.createTargetMachine();
+        if (!targetMachineOrErr)
+        {
+            return targetMachineOrErr.takeError();
+        }
+
+        return std::make_unique<llvm::orc::TMOwningSimpleCompiler>(std::move(*targetMachineOrErr), objectCache);
+    };
+
+    // the function is called directly, not through a packed wrapper, so only signatures we know how to call are accepted
+    auto mainLLVMFunc = llvmModule->getFunction(mainFuncName);
+    if (!mainLLVMFunc)
+    {
+        llvm::errs() << "JIT invocation failed, error: function '" << mainFuncName << "' is not found\n";
+        return -1;
+    }
+
+    auto mainFuncType = mainLLVMFunc->getFunctionType();
+    auto mainReturnsInt = mainFuncType->getReturnType()->isIntegerTy();
+    if (mainFuncType->getNumParams() != 0 || mainFuncType->isVarArg() ||
+        !(mainReturnsInt || mainFuncType->getReturnType()->isVoidTy()))
+    {
+        llvm::errs() << "JIT invocation failed, error: function '" << mainFuncName
+                     << "' must have no parameters and return nothing or an integer\n";
+        return -1;
+    }
+
+    auto mainReturnBits = mainReturnsInt ? mainFuncType->getReturnType()->getIntegerBitWidth() : 0;
+    if (mainReturnBits > 64)
+    {
+        llvm::errs() << "JIT invocation failed, error: function '" << mainFuncName << "' returns an integer wider than 64 bits\n";
+        return -1;
+    }
+
+    // declared before JIT, the object linking layer refers to it
+    JitProfileSections profileSections;
+    profileSections.allocateSection = profileAllocateSection;
+
+    std::unique_ptr<llvm::orc::LLJIT> ownJit;
+    std::unique_ptr<TieredJit> tieredJit;
+    llvm::orc::LLLazyJIT *lazyJit = nullptr;
+    if (jitTiered)
+    {
+        auto tieredJitOrErr = TieredJit::create(std::max(1u, jitTierThreshold.getValue()), getTierTransformer(0),
+                                                getTierTransformer(3));
+        if (!tieredJitOrErr)
+        {
+            llvm::errs() << tieredJitOrErr.takeError();
+            return -1;
+        }
+
+        tieredJit = std::move(*tieredJitOrErr);
+    }
+    else if (jitLazy)
+    {
+        llvm::orc::LLLazyJITBuilder jitBuilder;
+        jitBuilder.setCompileFunctionCreator(compileFunctionCreator);
+        if (profileGenerate)
+        {
+            jitBuilder.setObjectLinkingLayerCreator(getProfilingObjectLinkingLayerCreator(profileSections));
+        }
+
+        auto jitOrErr = jitBuilder.create();
+        if (!jitOrErr)
+        {
+            llvm::errs() << jitOrErr.takeError();
+            return -1;
+        }
+
+        lazyJit = jitOrErr->get();
+        ownJit = std::move(*jitOrErr);
+    }
+    else
+    {
+        llvm::orc::LLJITBuilder jitBuilder;
+        jitBuilder.setCompileFunctionCreator(compileFunctionCreator);
+        if (profileGenerate)
+        {
+            jitBuilder.setObjectLinkingLayerCreator(getProfilingObjectLinkingLayerCreator(profileSections));
+        }
+
+        auto jitOrErr = jitBuilder.create();
+        if (!jitOrErr)
+        {
+            llvm::errs() << jitOrErr.takeError();
+            return -1;
+        }
+
+        ownJit = std::move(*jitOrErr);
+    }
+
+    auto jit = tieredJit ? &tieredJit->getJIT() : ownJit.get();
+
+    llvmModule->setDataLayout(jit->getDataLayout());
+    llvmModule->setTargetTriple(jit->getTargetTriple().str());
+
+    // the same pipeline as for the whole module, in lazy mode it is applied to each function when it is requested,
+    // tiered JIT has own pipelines
+    auto optPipeline = getTransformer(enableOpt, optLevel, sizeLevel);
+    if (!tieredJit)
+    {
+        jit->getIRTransformLayer().setTransform(
+            [&](llvm::orc::ThreadSafeModule tsm, llvm::orc::MaterializationResponsibility &) -> llvm::Expected<llvm::orc::ThreadSafeModule> {
+                auto error = tsm.withModuleDo([&](llvm::Module &m) -> llvm::Error {
+                    if (objectCache)
+                    {
+                        // the compiler finds the object by module identifier
+                        auto moduleKey = objectCache->getModuleKey(m);
+                        m.setModuleIdentifier(moduleKey);
+                        if (objectCache->contains(moduleKey))
+                        {
+                            // nothing is optimized, so the phase is not in the time report of a cached module
+                            return llvm::Error::success();
+                        }
+                    }
+
+                    auto pipelineTiming = timing.nest(jitLazy ? "Lazy Compilation" : "LLVM Pipeline");
+                    if (auto error = optPipeline(&m))
+                    {
+                        return error;
+                    }
+
+                    if (profileGenerate)
+                    {
+                        takeProfileVersion(m, profileSections);
+                    }
+
+                    return llvm::Error::success();
+                });
+
+                if (error)
+                {
+                    return std::move(error);
+                }
+
+                return std::move(tsm);
+            });
+    }
+
+    auto &mainJD = jit->getMainJITDylib();
+    llvm::orc::MangleAndInterner interner(jit->getExecutionSession(), jit->getDataLayout());
+    if (auto error = mainJD.define(llvm::orc::absoluteSymbols(runtimeSymbolMap(interner))))
+    {
+        llvm::errs() << error;
+        return -1;
+    }
+
+    if (noGC)
+    {
+        reportMissingGCLibrary();
+        return -1;
+    }
+
+    // symbols of the process and of the loaded shared libraries
+    auto generatorOrErr = llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(jit->getDataLayout().getGlobalPrefix());
+    if (!generatorOrErr)
+    {
+        llvm::errs() << generatorOrErr.takeError();
+        return -1;
+    }
+
+    mainJD.addGenerator(std::move(*generatorOrErr));
+
+    llvm::orc::ThreadSafeModule threadSafeModule(std::move(llvmModule), std::move(llvmContext));
+    auto error = tieredJit ? tieredJit->addModule(std::move(threadSafeModule))
+                 : lazyJit ? lazyJit->addLazyIRModule(std::move(threadSafeModule))
+                           : jit->addIRModule(std::move(threadSafeModule));
+    if (error)
+    {
+        llvm::errs() << error;
+        return -1;
+    }
+
+    auto lookupAddress = [&](llvm::StringRef name) -> llvm::JITTargetAddress {
+        auto symbolOrErr = jit->lookup(name);
+        if (!symbolOrErr)
+        {
+            llvm::errs() << symbolOrErr.takeError();
+            return 0;
+        }
+
+        return symbolOrErr->getAddress();
+    };
+
+    // in lazy mode lookup returns stub, main function is compiled on the first call
+    auto mainAddress = lookupAddress(mainFuncName);
+    if (!mainAddress)
+    {
+        return -1;
+    }
+
+    materializationTiming.stop();
+
+    auto executionTiming = timing.nest("JIT Execution");
+
+    if (module.lookupSymbol("__mlir_gctors"))
+    {
+        auto gctorsAddress = lookupAddress("__mlir_gctors");
+        if (!gctorsAddress)
+        {
+            llvm::errs() << "JIT calling global constructors failed\n";
+            return -1;
+        }
+
+        reinterpret_cast<void (*)()>(gctorsAddress)();
+    }
+
+    auto exitCode = 0;
+    if (mainReturnBits == 0)
+    {
+        reinterpret_cast<void (*)()>(mainAddress)();
+    }
+    else if (mainReturnBits <= 32)
+    {
+        exitCode = getMainExitCode(reinterpret_cast<int32_t (*)()>(mainAddress)(), mainReturnBits);
+    }
+    else
+    {
+        exitCode = getMainExitCode(reinterpret_cast<int64_t (*)()>(mainAddress)(), mainReturnBits);
+    }
+
+    if (profileGenerate)
+    {
+        if (auto result = writeJitProfile(*jit, profileSections))
+        {
+            return result;
+        }
+    }
+
+    return exitCode;
+}
+
+int runJit(mlir::ModuleOp module, llvm::StringRef inputFilename, mlir::TimingScope &timing)
+{
+    initDialects(module);
+
+    // Initialize LLVM targets.
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+
+    auto optPipeline = getTransformer(enableOpt, optLevel, sizeLevel);
+
+    // If shared library implements custom mlir-runner library init and destroy
+    // functions, we'll use them to register the library with the execution
+    // engine. Otherwise we'll pass library directly to the execution engine.
+    mlir::SmallVector<mlir::SmallString<256>, 4> libPaths;
+
+    // Use absolute library path so that gdb can find the symbol table.
+    transform(clSharedLibs, std::back_inserter(libPaths), [](std::string libPath) {
+        mlir::SmallString<256> absPath(libPath.begin(), libPath.end());
+        cantFail(llvm::errorCodeToError(llvm::sys::fs::make_absolute(absPath)));
+        return absPath;
+    });
+
+    // Libraries that we'll pass to the ExecutionEngine for loading.
+    mlir::SmallVector<mlir::StringRef, 4> executionEngineLibs;
+
+    using MlirRunnerInitFn = void (*)(llvm::StringMap<void *> &);
+    using MlirRunnerDestroyFn = void (*)();
+
+    llvm::StringMap<void *> exportSymbols;
+    mlir::SmallVector<MlirRunnerDestroyFn> destroyFns;
+
+    // Handle libraries that do support mlir-runner init/destroy callbacks.
+    for (auto &libPath : libPaths)
+    {
+        LLVM_DEBUG(llvm::dbgs() << "loading lib at path: " << libPath.c_str() << "\n";);
+
+        std::string errMsg;
+        auto lib = llvm::sys::DynamicLibrary::getPermanentLibrary(libPath.c_str(), &errMsg);
+
+        if (errMsg.size() > 0)
+        {
+            llvm::errs() << "Loading error lib: " << errMsg << "\n";
+            return -1;
+        }
+
+        LLVM_DEBUG(llvm::dbgs() << "loaded path: " << libPath.c_str() << "\n";);
+
+        void *initSym = lib.getAddressOfSymbol("__mlir_runner_init");
+        if (!initSym)
+        {
+            LLVM_DEBUG(llvm::dbgs() << "missing __mlir_runner_init";);
+        }
+
+        void *destroySim = lib.getAddressOfSymbol("__mlir_runner_destroy");
+        if (!destroySim)
+        {
+            LLVM_DEBUG(llvm::dbgs() << "missing __mlir_runner_destroy";);
+        }
+
+        // Library does not support mlir runner, load it with ExecutionEngine.
+        if (!initSym || !destroySim)
+        {
+            executionEngineLibs.push_back(libPath);
+            continue;
+        }
+
+        LLVM_DEBUG(llvm::dbgs() << "added path: " << libPath.c_str() << "\n";);
+
+        auto initFn = reinterpret_cast<MlirRunnerInitFn>(initSym);
+        initFn(exportSymbols);
+
+        auto destroyFn = reinterpret_cast<MlirRunnerDestroyFn>(destroySim);
+        destroyFns.push_back(destroyFn);
+    }
+
+    auto noGC = false;
+
+    // Build a runtime symbol map from the config and exported symbols.
+    auto runtimeSymbolMap = [&](llvm::orc::MangleAndInterner interner) {
+        auto symbolMap = llvm::orc::SymbolMap();
+        for (auto &exportSymbol : exportSymbols)
+        {
+            LLVM_DEBUG(llvm::dbgs() << "loading symbol: " << exportSymbol.getKey() << "\n";);
+            symbolMap[interner(exportSymbol.getKey())] = llvm::JITEvaluatedSymbol::fromPointer(exportSymbol.getValue());
+        }
+
+#ifdef ENABLE_STACK_EXEC
+        // adding my ref to __enable_execute_stack
+        symbolMap[interner("__enable_execute_stack")] = llvm::JITEvaluatedSymbol::fromPointer(_mlir__enable_execute_stack);
+#endif        
+
+        if (!disableGC && symbolMap.count(interner("GC_init")) == 0)
+        {
+            noGC = true;
+        }
+
+        return symbolMap;
+    };
+
+    // tiered code is not cached, tier 2 depends on the run
+    std::unique_ptr<JitObjectCache> objectCache;
+    if (!cacheDir.empty() && !dumpObjectFile && !jitTiered)
+    {
+        objectCache = std::make_unique<JitObjectCache>(cacheDir, getCompileCacheOptionsKey());
+    }
+
+    // profile sections of instrumented objects are placed by profile runtime when they are loaded, it is possible only on ORC
+    if (jitLazy || jitTiered || objectCache || profileGenerate)
+    {
+        if (dumpObjectFile)
+        {
+            llvm::errs() << "-dump-object-file can't be used with --jit-lazy, --jit-tiered or --profile-generate\n";
+            return -1;
+        }
+
+        if (jitLazy && jitTiered)
+        {
+            llvm::errs() << "--jit-lazy and --jit-tiered can't be used together\n";
+            return -1;
+        }
+
+        // tier 2 functions are renamed and compiled separately, so they would not match the profile
+        if (jitTiered && (profileGenerate || !profileUse.empty()))
+        {
+            llvm::errs() << "--profile-generate and --profile-use can't be used with --jit-tiered\n";
+            return -1;
+        }
+
+        JitProfileSections::AllocateSectionFn profileAllocateSection = nullptr;
+        if (profileGenerate)
+        {
+            auto allocateSectionIt = exportSymbols.find("__tsc_profile_allocate_section");
+            if (allocateSectionIt == exportSymbols.end() || exportSymbols.count("__tsc_profile_write") == 0)
+            {
+                llvm::errs() << "JIT initialization failed. Missing profile runtime. Did you forget to provide it via "
+                                "'--shared-libs=TypeScriptRuntime' (built with clang_rt.profile)?\n";
+                return -1;
+            }
+
+            profileAllocateSection = reinterpret_cast<JitProfileSections::AllocateSectionFn>(allocateSectionIt->second);
+        }
+
+        auto result = runOrcJit(module, timing, runtimeSymbolMap, noGC, objectCache.get(), profileAllocateSection);
+
+        // Run all dynamic library destroy callbacks to prepare for the shutdown.
+        llvm::for_each(destroyFns, [](MlirRunnerDestroyFn destroy) { destroy(); });
+        return result;
+    }
+
+    // Create an MLIR execution engine. The execution engine eagerly JIT-compiles
+    // the module.
+    auto materializationTiming = timing.nest("JIT Materialization");
+    mlir::ExecutionEngineOptions engineOptions;
+    engineOptions.transformer = [&](llvm::Module *m) {
+        auto llvmPipelineTiming = materializationTiming.nest("LLVM Pipeline");
+        return optPipeline(m);
+    };
+    auto maybeEngine = mlir::ExecutionEngine::create(module, engineOptions);
+    assert(maybeEngine && "failed to construct an execution engine");
+    auto &engine = maybeEngine.get();
+
+    engine->registerSymbols(runtimeSymbolMap);
+    if (noGC)
+    {
+        reportMissingGCLibrary();
+        return -1;
+    }
+
+    if (dumpObjectFile)
+    {
+        auto expectedFPtr = engine->lookup(mainFuncName);
+        if (!expectedFPtr)
+        {
+            llvm::errs() << expectedFPtr.takeError();
+            return -1;
+        }
+
+        engine->dumpToObjectFile(objectFilename.empty() ? (inputFilename + ".o").str() : objectFilename.getValue());
+        return 0;
+    }
+
+    if (auto expectedFPtr = engine->lookup(mainFuncName))
+    {
+        materializationTiming.stop();
+    }
+    else
+    {
+        llvm::errs() << expectedFPtr.takeError();
+        return -1;
+    }
+
+    auto executionTiming = timing.nest("JIT Execution");
+
+    if (module.lookupSymbol("__mlir_gctors"))
+    {
+        auto gctorsResult = engine->invokePacked("__mlir_gctors");
+        if (gctorsResult)
+        {
+            llvm::errs() << "JIT calling global constructors failed, error: " << gctorsResult << "\n";
+            return -1;
+        }
+    }
+
+    // the exit code is the integer result of main as in runOrcJit (used for --cache-dir), the packed wrapper stores the
+    // result to the memory after the arguments
+    auto mainFuncOp = module.lookupSymbol<mlir::LLVM::LLVMFuncOp>(mainFuncName);
+    auto mainResultType =
+        mainFuncOp ? mainFuncOp.getFunctionType().getReturnType().dyn_cast<mlir::IntegerType>() : mlir::IntegerType();
+    if (mainResultType && mainResultType.getWidth() > 64)
+    {
+        llvm::errs() << "JIT invocation failed, error: function '" << mainFuncName << "' returns an integer wider than 64 bits\n";
+        return -1;
+    }
+
+    // Invoke the JIT-compiled function.
+    int64_t mainResult = 0;
+    void *mainResultPtr = &mainResult;
+    auto invocationResult = mainResultType ? engine->invokePacked(mainFuncName, mainResultPtr) : engine->invokePacked(mainFuncName);
+
+    // Run all dynamic library destroy callbacks to prepare for the shutdown.
+    llvm::for_each(destroyFns, [](MlirRunnerDestroyFn destroy) { destroy(); });
+
+    if (invocationResult)
+    {
+        llvm::errs() << "JIT invocation failed, error: " << invocationResult << "\n";
+        return -1;
+    }
+
+    return mainResultType ? getMainExitCode(mainResult, mainResultType.getWidth()) : 0;
+}
+
+int compileInput(llvm::StringRef inputFilename, mlir::TimingScope &timing)
+{
+    // Try to skip the whole compilation if result is in the cache.
+    std::unique_ptr<CompileCache> compileCache;
+    auto isCacheableAction = emitAction == Action::DumpLLVMIR || emitAction == Action::DumpObj || emitAction == Action::BuildExe;
+    if (!cacheDir.empty() && isCacheableAction && inputType != InputType::MLIR && !llvm::StringRef(inputFilename).endswith(".mlir"))
+    {
+        auto cacheTiming = timing.nest("Cache Lookup");
+        compileCache = std::make_unique<CompileCache>(cacheDir);
+
+        int result;
+        if (runFromCompileCache(*compileCache, inputFilename, timing, result))
+        {
+            return result;
+        }
+    }
+
+    // If we aren't dumping the AST, then we are compiling with/to MLIR.
+
+    auto initTiming = timing.nest("Initialization");
+    std::unique_ptr<mlir::MLIRContext> ownContext;
+    if (!serverContext)
+    {
+        ownContext = std::make_unique<mlir::MLIRContext>();
+        loadDialects(*ownContext);
+        if (inputFilenames.size() > 1)
+        {
+            // input files are already compiled in parallel
+            ownContext->disableMultithreading();
+        }
+    }
+
+    auto &context = serverContext ? *serverContext : *ownContext;
+    initTiming.stop();
+
+    mlir::OwningOpRef<mlir::ModuleOp> module;
+    std::vector<std::string> dependencies;
+    std::vector<std::string> importedModules;
+    if (int error = loadAndProcessMLIR(context, inputFilename, module, timing, &dependencies, &importedModules))
+    {
+        return error;
+    }
+
+    // If we aren't exporting to non-mlir, then we are done.
+    bool isOutputingMLIR = emitAction <= Action::DumpMLIRLLVM;
+    if (isOutputingMLIR)
+    {
+        module->dump();
+        return 0;
+    }
+
+    // Check to see if we are compiling to LLVM IR.
+    if (emitAction == Action::DumpLLVMIR)
+    {
+        return dumpLLVMIR(*module, timing, compileCache.get(), dependencies);
+    }
+
+    // Otherwise, we must be running the jit.
+    if (emitAction == Action::RunJIT)
+    {
+        return runJit(*module, inputFilename, timing);
+    }
+
+    if (emitAction == Action::DumpObj)
+    {
+        return compileToObj(*module, inputFilename, timing, compileCache.get(), dependencies, importedModules);
+    }
+
+    if (emitAction == Action::BuildExe)
+    {
+        return compileToExe(*module, inputFilename, timing, compileCache.get(), dependencies, importedModules);
     }
 
     llvm::errs() << "No action specified (parsing only?), use -emit=<action>\n";
     return -1;
 }
+
+void printTimeReport(TimeReportManager &timeReportManager)
+{
+    auto format = timeReport == JsonTimeReport ? TimeReportFormat::Json : TimeReportFormat::Text;
+    if (timeReportFilename.empty())
+    {
+        timeReportManager.print(llvm::errs(), format);
+        return;
+    }
+
+    std::error_code ec;
+    llvm::raw_fd_ostream os(timeReportFilename, ec, llvm::sys::fs::OF_Text);
+    if (ec)
+    {
+        llvm::errs() << "Could not open time report file: " << ec.message() << "\n";
+        return;
+    }
+
+    timeReportManager.print(os, format);
+}
+
+// checks that options can be applied to all inputs
+bool validateBatchOptions()
+{
+    if (emitAction != Action::DumpObj && emitAction != Action::BuildExe)
+    {
+        llvm::errs() << "Several input files can be compiled only with -emit=obj or -emit=exe\n";
+        return false;
+    }
+
+    if (!outputFilename.empty() || !objectFilename.empty())
+    {
+        llvm::errs() << "-o and -object-filename can't be used with several input files\n";
+        return false;
+    }
+
+    // outputs are created in current folder
+    llvm::StringMap<llvm::StringRef> outputs;
+    for (auto &inputFilename : inputFilenames)
+    {
+        auto outputFileName = emitAction == Action::DumpObj ? getObjOutputFileName(inputFilename) : getExeOutputFileName(inputFilename);
+        auto inserted = outputs.try_emplace(outputFileName, inputFilename);
+        if (!inserted.second)
+        {
+            llvm::errs() << "Input files " << inserted.first->second << " and " << inputFilename << " have the same output file "
+                         << outputFileName << "\n";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int compileInputs(mlir::TimingScope &timing)
+{
+    if (inputFilenames.size() == 1)
+    {
+        return compileInput(inputFilenames.front(), timing);
+    }
+
+    if (!validateBatchOptions())
+    {
+        return -1;
+    }
+
+    // registration of targets is not thread safe
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+
+    auto strategy = jobs == 0 ? llvm::hardware_concurrency() : llvm::hardware_concurrency(jobs);
+    llvm::ThreadPool threadPool(strategy);
+
+    std::vector<int> results(inputFilenames.size());
+    for (auto index : llvm::seq<size_t>(0, inputFilenames.size()))
+    {
+        threadPool.async([&, index]() {
+            auto &inputFilename = inputFilenames[index];
+            auto fileTiming = timing.nest(inputFilename.c_str(), [&]() { return inputFilename; });
+            results[index] = compileInput(inputFilename, fileTiming);
+        });
+    }
+
+    threadPool.wait();
+
+    auto failed = 0;
+    for (auto index : llvm::seq<size_t>(0, inputFilenames.size()))
+    {
+        if (results[index])
+        {
+            llvm::errs() << "Compilation of " << inputFilenames[index] << " failed\n";
+            failed++;
+        }
+    }
+
+    if (failed)
+    {
+        llvm::errs() << failed << " of " << inputFilenames.size() << " files failed to compile\n";
+        return 1;
+    }
+
+    return 0;
+}
+
+int runCompilation()
+{
+    if (inputFilenames.empty())
+    {
+        inputFilenames.push_back("-");
+    }
+
+    if (emitAction == Action::DumpAST)
+    {
+        if (inputFilenames.size() > 1)
+        {
+            llvm::errs() << "Several input files can be compiled only with -emit=obj or -emit=exe\n";
+            return -1;
+        }
+
+        return dumpAST(inputFilenames.front());
+    }
+
+    if (profileGenerate && !profileUse.empty())
+    {
+        llvm::errs() << "--profile-generate and --profile-use can't be used together\n";
+        return -1;
+    }
+
+    // otherwise PGO pass reports it for each module
+    if (!profileUse.empty() && !llvm::sys::fs::exists(profileUse))
+    {
+        llvm::errs() << "Profile file " << profileUse << " is not found\n";
+        return -1;
+    }
+
+    auto result = 0;
+    if (timeReport == NoTimeReport)
+    {
+        mlir::TimingScope noTiming;
+        result = compileInputs(noTiming);
+    }
+    else
+    {
+        TimeReportManager timeReportManager;
+        {
+            auto timing = timeReportManager.getRootScope();
+            result = compileInputs(timing);
+        }
+
+        printTimeReport(timeReportManager);
+    }
+
+    if (!cacheDir.empty() && cacheSizeLimit > 0)
+    {
+        CompileCache::prune(cacheDir, static_cast<uint64_t>(cacheSizeLimit) * 1024 * 1024);
+    }
+
+    return result;
+}
+
+static const llvm::StringRef exitingOptions[] = {"h", "help", "help-hidden", "help-list", "help-list-hidden", "version"};
+
+int runServer(const char *argv0)
+{
+    // everything what does not depend on the input is initialized once, before workers are started
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+
+    CompileServerOptions options;
+    options.workers = serverWorkers ? serverWorkers.getValue() : llvm::hardware_concurrency().compute_thread_count();
+    options.maxRequests = serverMaxRequests;
+    options.maxMemory = static_cast<uint64_t>(serverMaxMemory) * 1024 * 1024;
+
+    // each worker has its own context, it is released with the worker when the worker is replaced
+    std::unique_ptr<mlir::MLIRContext> workerContext;
+    auto initWorker = [&]() {
+        workerContext = std::make_unique<mlir::MLIRContext>();
+        loadDialects(*workerContext);
+        serverContext = workerContext.get();
+        serverIncludeFilesCache = createIncludeFilesCache();
+    };
+
+    return runCompileServer(socketPath.getValue(), options, initWorker, [&](llvm::ArrayRef<std::string> args) {
+        llvm::SmallVector<const char *> requestArgv;
+        requestArgv.push_back(argv0);
+        for (auto &arg : args)
+        {
+            // these options print and exit the process
+            llvm::StringRef option(arg);
+            if (option.startswith("-") && llvm::is_contained(exitingOptions, option.ltrim('-').split('=').first))
+            {
+                llvm::errs() << arg << " can't be sent to the compile server\n";
+                return 1;
+            }
+
+            requestArgv.push_back(arg.c_str());
+        }
+
+        // options are global, values of previous request are reset to defaults
+        cl::ResetAllOptionOccurrences();
+        if (!cl::ParseCommandLineOptions(requestArgv.size(), requestArgv.data(), "TypeScript compiler\n", &llvm::errs()))
+        {
+            return 1;
+        }
+
+        if (serve || connectToServer)
+        {
+            llvm::errs() << "--serve and --connect can't be sent to the compile server\n";
+            return 1;
+        }
+
+        if (emitAction == Action::RunJIT)
+        {
+            // JIT-ed code can exit, crash or leave its global state, it runs in a process of its own; threads of the
+            // context of the worker are not in that process, so it is not used there
+            return runInChildProcess([&]() {
+                serverContext = nullptr;
+                return runCompilation();
+            });
+        }
+
+        return runCompilation();
+    });
+}
+
+int runClient(int argc, char **argv)
+{
+    // forward everything except options of the connection itself
+    std::vector<std::string> args;
+    for (auto i = 1; i < argc; i++)
+    {
+        llvm::StringRef arg(argv[i]);
+        auto option = arg.ltrim('-').split('=');
+        if (arg.startswith("-") && (option.first == "connect" || option.first == "socket"))
+        {
+            // value of --socket can be the next argument
+            if (option.first == "socket" && !arg.contains('='))
+            {
+                i++;
+            }
+
+            continue;
+        }
+
+        args.push_back(arg.str());
+    }
+
+    return runCompileServerClient(socketPath.getValue(), args);
+}
+
+int main(int argc, char **argv)
+{
+    // Register any command line options.
+    mlir::registerAsmPrinterCLOptions();
+    mlir::registerMLIRContextCLOptions();
+    mlir::registerPassManagerCLOptions();
+    mlir::registerDefaultTimingManagerCLOptions();
+    mlir::DebugCounter::registerCLOptions();
+
+    cl::ParseCommandLineOptions(argc, argv, "TypeScript compiler\n");
+
+    if (serve)
+    {
+        return runServer(argv[0]);
+    }
+
+    if (connectToServer)
+    {
+        return runClient(argc, argv);
+    }
+
+    return runCompilation();
+}